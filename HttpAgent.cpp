@@ -3,9 +3,17 @@
 
 #include <curl/curl.h>
 
+#include <ostream>
+#include <atomic>
 #include <mutex>
 #include <cstring>
-#include <algorithm>
+#include <cerrno>
+
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace Utility
 {
@@ -14,6 +22,61 @@ namespace http
     namespace
     {
         std::once_flag  curlInit;
+
+        std::atomic<unsigned long>  specIds{0};
+
+        curl_slist*
+        append( curl_slist* lp, Agent::Headers const& headers )
+        {
+            for ( auto& _hdr : headers ) { lp = ::curl_slist_append( lp, _hdr.c_str() ); }
+            return lp;
+        }
+
+        //!> The first CR or LF in [from, end), or end
+        char const*
+        find_eol( char const* from, char const* end )
+        {
+#ifdef __SSE2__
+            __m128i const   _cr(_mm_set1_epi8( '\r' ));
+            __m128i const   _lf(_mm_set1_epi8( '\n' ));
+            for ( ; end - from >= 16; from += 16 )
+            {
+                __m128i _v(_mm_loadu_si128( reinterpret_cast<__m128i const*>(from) ));
+                if ( int _m = _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( _v, _cr ), _mm_cmpeq_epi8( _v, _lf ) ) ) )
+                {
+                    return from + __builtin_ctz( _m );
+                }
+            }
+#endif
+            for ( ; from < end; ++from )
+            {
+                if ( *from == '\r' || *from == '\n' ) { return from; }
+            }
+            return end;
+        }
+    }
+
+    bool
+    FdSink::write( char const* buf, std::size_t len )
+    {
+        while ( len > 0 )
+        {
+            ssize_t _out(::write( fd_, buf, len ));
+            if ( _out < 0 )
+            {
+                if ( errno == EINTR ) { continue; }
+                return false;
+            }
+            buf += _out;
+            len -= _out;
+        }
+        return true;
+    }
+
+    bool
+    StreamSink::write( char const* buf, std::size_t len )
+    {
+        return static_cast<bool>(os_.write( buf, len ));
     }
 
     Initializer::Initializer()
@@ -21,17 +84,44 @@ namespace http
         std::call_once( curlInit, [](){ ::curl_global_init( CURL_GLOBAL_ALL ); } );
     }
 
+    RequestSpec::~RequestSpec() noexcept
+    {
+        if ( lp_ ) { ::curl_slist_free_all( static_cast<curl_slist*>(lp_) ); }
+    }
+
+    RequestSpec::RequestSpec(std::string const& url, Method method, Agent::Headers const& headers, char const* type)
+    : url_(url)
+    , method_(method)
+    , lp_(append( nullptr, headers ))
+    , id_(++specIds)
+    {
+        if ( type ) { lp_ = ::curl_slist_append( static_cast<curl_slist*>(lp_), type ); }
+    }
+
+//=========================================================================
     Agent::~Agent() noexcept
     {
         free_slist_();
         ::curl_easy_cleanup( curl_ );
     }
 
+    Agent::Agent(Sink& sink, bool keepeol)
+    : sink_(&sink)
+    , curl_(::curl_easy_init())
+    , respCode_(200)
+    , lp_(nullptr)
+    , typedLp_(nullptr)
+    {
+        set_options_( keepeol );
+    }
+
     Agent::Agent(std::ostream& os, bool keepeol)
-    : osi_(os)
+    : own_(std::make_unique<StreamSink>(os))
+    , sink_(own_.get())
     , curl_(::curl_easy_init())
     , respCode_(200)
     , lp_(nullptr)
+    , typedLp_(nullptr)
     {
         set_options_( keepeol );
     }
@@ -41,8 +131,10 @@ namespace http
     {
         errbuf_[0] = '\0';
         type_ = nullptr;
+        plain_();
         ::curl_easy_setopt( curl_, CURLOPT_HTTPGET, 1L );
         ::curl_easy_setopt( curl_, CURLOPT_URL, url );
+        ::curl_easy_setopt( curl_, CURLOPT_HTTPHEADER, lp_ );
         return perform_();
         
     }
@@ -52,16 +144,45 @@ namespace http
     {
         errbuf_[0] = '\0';
         type_ = nullptr;
+        plain_();
         ::curl_easy_setopt( curl_, CURLOPT_POSTFIELDS, const_cast<char*>(data) );
         ::curl_easy_setopt( curl_, CURLOPT_POSTFIELDSIZE, size );
-        if ( type )
-        {
-            lp_ = ::curl_slist_append( static_cast<curl_slist*>(lp_), type );
-        }
+        ::curl_easy_setopt( curl_, CURLOPT_HTTPHEADER, type ? typed_( type ) : lp_ );
         ::curl_easy_setopt( curl_, CURLOPT_URL, url );
         return perform_();        
     }
 
+    bool
+    Agent::execute( RequestSpec const& spec, std::string_view body ) const
+    {
+        errbuf_[0] = '\0';
+        type_ = nullptr;
+        using Method = RequestSpec::Method;
+        if ( spec_ != spec.id() )
+        {
+            plain_();
+            switch ( spec.method() )
+            {
+            case Method::GET:    ::curl_easy_setopt( curl_, CURLOPT_HTTPGET, 1L ); break;
+            case Method::POST:   ::curl_easy_setopt( curl_, CURLOPT_POST, 1L ); break;
+            case Method::PUT:    ::curl_easy_setopt( curl_, CURLOPT_CUSTOMREQUEST, "PUT" ); break;
+            case Method::DELETE:
+                ::curl_easy_setopt( curl_, CURLOPT_HTTPGET, 1L );
+                ::curl_easy_setopt( curl_, CURLOPT_CUSTOMREQUEST, "DELETE" );
+                break;
+            }
+            ::curl_easy_setopt( curl_, CURLOPT_URL, spec.url().c_str() );
+            ::curl_easy_setopt( curl_, CURLOPT_HTTPHEADER, spec.headers() );
+            spec_ = spec.id();
+        }
+        if ( spec.method() == Method::POST || spec.method() == Method::PUT )
+        {   // the body is all that changes
+            ::curl_easy_setopt( curl_, CURLOPT_POSTFIELDS, body.data() );
+            ::curl_easy_setopt( curl_, CURLOPT_POSTFIELDSIZE_LARGE, curl_off_t(body.size()) );
+        }
+        return perform_();
+    }
+
     Agent&
     Agent::set_headers( Headers const& headers )
     {
@@ -81,17 +202,20 @@ namespace http
     std::size_t
     Agent::on_data0_( char* buf, std::size_t len )
     {
-        std::copy( buf, buf + len, osi_ );
-        return len;
+        return sink_->write( buf, len ) ? len : 0;
     }
 
+    //!> Runs between line ends go to the sink whole
     std::size_t
     Agent::on_data1_( char* buf, std::size_t len )
     {
-        std::copy_if( buf, buf + len, osi_, []( char const c ) -> bool
+        char const* _end(buf + len);
+        for ( char const* _from(buf); _from < _end; )
         {
-            return ::strchr( "\r\n", c ) == nullptr;
-        } );
+            char const* _eol(find_eol( _from, _end ));
+            if ( _eol > _from && !sink_->write( _from, _eol - _from ) ) { return 0; }
+            _from = _eol + 1;
+        }
         return len;
     }
 
@@ -117,20 +241,44 @@ namespace http
     }
 
     void
-    Agent::set_headers_( Headers const& headers ) const
+    Agent::set_headers_( Headers const& headers )
     {
         if ( headers.empty() ) { return; }
 
-        for ( auto& hdr : headers )
+        lp_ = append( static_cast<curl_slist*>(lp_), headers );
+        headers_.insert( headers_.end(), headers.begin(), headers.end() );
+        if ( typedLp_ )
         {
-            lp_ = ::curl_slist_append( static_cast<curl_slist*>(lp_), hdr.c_str() );
+            ::curl_slist_free_all( static_cast<curl_slist*>(typedLp_) );
+            typedLp_ = nullptr;
         }
     }
 
+    //!> The headers for a post() of this type: rebuilt only when the type changes
+    void*
+    Agent::typed_( char const* type ) const
+    {
+        if ( typedLp_ && typedFor_ == type ) { return typedLp_; }
+        if ( typedLp_ ) { ::curl_slist_free_all( static_cast<curl_slist*>(typedLp_) ); }
+        typedLp_  = ::curl_slist_append( append( nullptr, headers_ ), type );
+        typedFor_ = type;
+        return typedLp_;
+    }
+
+    //!> Out of a RequestSpec's state, if the handle was in one
+    void
+    Agent::plain_() const
+    {
+        if ( spec_ == 0 ) { return; }
+        ::curl_easy_setopt( curl_, CURLOPT_CUSTOMREQUEST, nullptr );
+        ::curl_easy_setopt( curl_, CURLOPT_HTTPHEADER, lp_ );
+        spec_ = 0;
+    }
+
     bool
     Agent::perform_() const
     {
-        if ( lp_ ) { ::curl_easy_setopt( curl_, CURLOPT_HTTPHEADER, lp_ ); }
+        sink_->reset();
         auto    _ok(::curl_easy_perform( curl_ ));
         ::curl_easy_getinfo( curl_, CURLINFO_RESPONSE_CODE, &respCode_ );
         //::curl_easy_getinfo( curl_, CURLINFO_SIZE_DOWNLOAD_T, &size_ );
@@ -152,6 +300,11 @@ namespace http
             ::curl_slist_free_all( static_cast<curl_slist*>(lp_) );
             lp_ = nullptr;
         }
+        if ( typedLp_ )
+        {
+            ::curl_slist_free_all( static_cast<curl_slist*>(typedLp_) );
+            typedLp_ = nullptr;
+        }
     }
 
 }} // namespace http, Utility
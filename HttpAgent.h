@@ -5,9 +5,10 @@
 
 #include <vector>
 #include <string>
-#include <iterator>
+#include <string_view>
+#include <functional>
+#include <memory>
 #include <iosfwd>
-#include <sstream>
 
 namespace Utility
 {
@@ -15,14 +16,85 @@ namespace http
 {
     struct Initializer { Initializer(); };
 
+    /**
+     * @class Sink
+     * @brief Where a response body goes, a chunk at a time.
+     */
+    class Sink
+    {
+    public:
+        virtual ~Sink() noexcept = default;
+        virtual void reset() {} // a response begins
+        virtual bool write( char const* buf, std::size_t len ) = 0; // false: abandon the transfer
+    };
+
+    //!> Into a buffer that keeps its capacity from one response to the next
+    class BufferSink
+    : public Sink
+    {
+    public:
+        void reset() override { buf_.clear(); }
+        bool write( char const* buf, std::size_t len ) override { buf_.append( buf, len ); return true; }
+
+        std::string_view view() const { return buf_; }
+        std::string take() { return std::move(buf_); }
+
+    private:
+        std::string buf_;
+    };
+
+    class CallbackSink
+    : public Sink
+    {
+    public:
+        using Callback = std::function<bool(std::string_view)>;
+        explicit CallbackSink(Callback callback) : callback_(std::move(callback)) {}
+        bool write( char const* buf, std::size_t len ) override { return callback_( std::string_view(buf, len) ); }
+
+    private:
+        Callback    callback_;
+    };
+
+    class FdSink
+    : public Sink
+    {
+    public:
+        explicit FdSink(int fd) : fd_(fd) {}
+        bool write( char const* buf, std::size_t len ) override;
+
+    private:
+        int     fd_; // not owned
+    };
+
+    class StreamSink
+    : public Sink
+    {
+    public:
+        explicit StreamSink(std::ostream& os) : os_(os) {}
+        bool write( char const* buf, std::size_t len ) override;
+
+    private:
+        std::ostream&   os_;
+    };
+
+    class RequestSpec;
+
+    /**
+     * @class Agent
+     * @brief Blocking requests on one curl handle. The body goes to a
+     * Sink: CR and LF are dropped unless keepeol.
+     * Repeated execute()s of one RequestSpec set only the body on the
+     * handle: the URL, method and headers stay as they were.
+     */
     class Agent
     : Initializer
     {
-        using Iterator = std::ostream_iterator<char>;
     public:
         using Headers = std::vector<std::string>;
         ~Agent() noexcept;
         explicit
+        Agent(Sink& sink, bool keepeol = false);
+        explicit
         Agent(std::ostream& os, bool keepeol = false);
 
         long get_code() const { return respCode_; }
@@ -35,20 +107,30 @@ namespace http
         // default: "Content-Type: application/x-www-forms-urlencoded"
         bool post( char const* url, char const* data, long size, char const* type = nullptr ) const;
 
+        // the spec must outlive its use here (curl keeps its header list)
+        bool execute( RequestSpec const& spec, std::string_view body = std::string_view() ) const;
+
         Agent& set_headers( Headers const& headers = Headers() );
         Agent& set_timeout( long timeout = 0 );
 
     private:
-        Iterator        osi_;
+        std::unique_ptr<StreamSink> own_; // for an ostream
+        Sink*           sink_;
         void*           curl_; // typedef void* CURL
         long            respCode_;
         mutable void*   lp_; // struct curl_slist*
+        Headers         headers_;     // in lp_
+        mutable void*   typedLp_;     // headers_ and a post() content type
+        mutable std::string typedFor_;
+        mutable unsigned long spec_{0}; // whose state the handle has, if any
         mutable char*   type_;
         mutable long    size_;
         mutable char    errbuf_[256]; // CURL_ERROR_SIZE
 
         void set_options_( bool keepeol ) const;
-        void set_headers_( Headers const& ) const;
+        void set_headers_( Headers const& );
+        void* typed_( char const* type ) const;
+        void plain_() const;
         bool perform_() const;
         void free_slist_() const;
 
@@ -59,13 +141,44 @@ namespace http
         static std::size_t wr_cb1( char* buf, std::size_t size, std::size_t nmemb, void* optr );
     };
 
+    /**
+     * @class RequestSpec
+     * @brief A request prepared once: URL, method and headers, with the
+     * curl header list built here. Immutable, so one can serve several
+     * Agents (on one thread each).
+     */
+    class RequestSpec
+    {
+    public:
+        enum class Method { GET, POST, PUT, DELETE };
+
+        ~RequestSpec() noexcept;
+        // type: as for Agent::post()
+        explicit
+        RequestSpec(std::string const& url, Method method = Method::GET, Agent::Headers const& headers = Agent::Headers(), char const* type = nullptr);
+        // Rule of Five
+        RequestSpec(RequestSpec const&) = delete;
+        RequestSpec& operator=( RequestSpec const& ) = delete;
+
+        std::string const& url() const { return url_; }
+        Method method() const { return method_; }
+        void* headers() const { return lp_; } // struct curl_slist*
+        unsigned long id() const { return id_; }
+
+    private:
+        std::string     url_;
+        Method          method_;
+        void*           lp_;
+        unsigned long   id_;  // unique, never 0
+    };
+
     class SimpleAgent
     {
     public:
         ~SimpleAgent() noexcept = default;
         explicit
         SimpleAgent(bool keepeol = false)
-        : agent_(oss_, keepeol)
+        : agent_(sink_, keepeol)
         {}
 
         explicit
@@ -80,7 +193,9 @@ namespace http
         char const* get_error() const { return agent_.get_error(); }
         char const* get_content_type() const { return agent_.get_content_type(); }
 
-        std::string get_data() { return oss_.str(); }
+        std::string get_data() const { return std::string(sink_.view()); }
+        std::string_view get_view() const { return sink_.view(); } // until the next request
+        std::string take_data() { return sink_.take(); }
 
         SimpleAgent& set_headers( Agent::Headers const& headers )
         {
@@ -96,11 +211,7 @@ namespace http
 
         bool operator()( std::string const& url ) { return operator()( url.c_str() ); }
 
-        bool operator()( char const* url )
-        {
-            oss_.str( "" );
-            return agent_.get( url );
-        }
+        bool operator()( char const* url ) { return agent_.get( url ); }
 
         bool operator()( std::string const& url, char const* data, long size, char const* type = nullptr )
         {
@@ -109,13 +220,17 @@ namespace http
 
         bool operator()( char const* url, char const* data, long size, char const* type = nullptr )
         {
-            oss_.str( "" );
             return agent_.post( url, data, size, type );
         }
 
+        bool operator()( RequestSpec const& spec, std::string_view body = std::string_view() )
+        {
+            return agent_.execute( spec, body );
+        }
+
     private:
-        std::ostringstream  oss_;
-        Agent               agent_;
+        BufferSink  sink_;
+        Agent       agent_;
     };
 
 }} // namespace http, Utility
@@ -0,0 +1,257 @@
+/** ======================================================================+
+ + Copyright @2020-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#include "HttpAsyncAgent.h"
+
+#include <curl/curl.h>
+
+#include <utility>
+
+namespace Utility
+{
+namespace http
+{
+    struct AsyncAgent::Transfer
+    {
+        std::string     url_;
+        std::string     data_;      // posted: must outlive the transfer
+        bool            post_{false};
+        Headers         headers_;
+        curl_slist*     lp_{nullptr};
+        Callback        done_;
+        CURL*           curl_{nullptr};
+        Response        resp_;
+        char            errbuf_[CURL_ERROR_SIZE];
+
+        ~Transfer() noexcept { if ( lp_ ) { ::curl_slist_free_all( lp_ ); } }
+
+        static std::size_t
+        on_data( char* buf, std::size_t size, std::size_t nmemb, void* tptr )
+        {
+            static_cast<Transfer*>(tptr)->resp_.body_.append( buf, size * nmemb );
+            return size * nmemb;
+        }
+    };
+
+    namespace
+    {
+        CURLM* multi( void* ptr ) { return static_cast<CURLM*>(ptr); }
+    }
+
+    AsyncAgent::~AsyncAgent() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> _guard(mx_);
+            stopped_ = true;
+        }
+        ::curl_multi_wakeup( multi( multi_ ) );
+        worker_.join();
+        for ( auto _curl : idle_ ) { ::curl_easy_cleanup( _curl ); }
+        ::curl_multi_cleanup( multi( multi_ ) );
+    }
+
+    AsyncAgent::AsyncAgent(Options const& options)
+    : options_(options)
+    , multi_(::curl_multi_init())
+    {
+        ::curl_multi_setopt( multi( multi_ ), CURLMOPT_PIPELINING, options_.http2_ ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING );
+        ::curl_multi_setopt( multi( multi_ ), CURLMOPT_MAX_HOST_CONNECTIONS, options_.hostConns_ );
+        ::curl_multi_setopt( multi( multi_ ), CURLMOPT_MAX_TOTAL_CONNECTIONS, options_.totalConns_ );
+        ::curl_multi_setopt( multi( multi_ ), CURLMOPT_MAXCONNECTS, options_.totalConns_ );
+        worker_ = std::thread(&AsyncAgent::run_, this);
+    }
+
+    void
+    AsyncAgent::get( std::string const& url, Callback done, Headers const& headers )
+    {
+        auto    _transfer(std::make_unique<Transfer>());
+        _transfer->url_     = url;
+        _transfer->headers_ = headers;
+        _transfer->done_    = std::move(done);
+        submit_( std::move(_transfer) );
+    }
+
+    std::future<Response>
+    AsyncAgent::get( std::string const& url, Headers const& headers )
+    {
+        auto    _promise(std::make_shared<std::promise<Response>>());
+        get( url, [_promise]( Response&& resp ) { _promise->set_value( std::move(resp) ); }, headers );
+        return _promise->get_future();
+    }
+
+    void
+    AsyncAgent::post( std::string const& url, std::string data, Callback done, char const* type, Headers const& headers )
+    {
+        auto    _transfer(std::make_unique<Transfer>());
+        _transfer->url_     = url;
+        _transfer->data_    = std::move(data);
+        _transfer->post_    = true;
+        _transfer->headers_ = headers;
+        if ( type ) { _transfer->headers_.emplace_back( type ); }
+        _transfer->done_    = std::move(done);
+        submit_( std::move(_transfer) );
+    }
+
+    std::future<Response>
+    AsyncAgent::post( std::string const& url, std::string data, char const* type, Headers const& headers )
+    {
+        auto    _promise(std::make_shared<std::promise<Response>>());
+        auto    _future(_promise->get_future());
+        post( url, std::move(data), [_promise]( Response&& resp ) { _promise->set_value( std::move(resp) ); }, type, headers );
+        return _future;
+    }
+
+    std::size_t
+    AsyncAgent::pending() const
+    {
+        std::lock_guard<std::mutex> _guard(mx_);
+        return pending_;
+    }
+
+//=========================================================================
+
+    void
+    AsyncAgent::submit_( TransferPtr transfer )
+    {
+        {
+            std::lock_guard<std::mutex> _guard(mx_);
+            if ( !stopped_ )
+            {
+                incoming_.push_back( std::move(transfer) );
+                ++pending_;
+            }
+        }
+        if ( transfer )
+        {
+            transfer->resp_.result_ = CURLE_ABORTED_BY_CALLBACK;
+            transfer->resp_.error_  = "agent stopped";
+            if ( transfer->done_ ) { transfer->done_( std::move(transfer->resp_) ); }
+            return;
+        }
+        ::curl_multi_wakeup( multi( multi_ ) );
+    }
+
+    //!> The worker: everything curl is done here.
+    void
+    AsyncAgent::run_()
+    {
+        Transfers   _incoming;
+        while ( true )
+        {
+            {
+                std::lock_guard<std::mutex> _guard(mx_);
+                if ( stopped_ ) { break; }
+                _incoming.swap( incoming_ );
+            }
+            for ( auto& _transfer : _incoming ) { start_( std::move(_transfer) ); }
+            _incoming.clear();
+
+            int     _running(0);
+            ::curl_multi_perform( multi( multi_ ), &_running );
+            reap_();
+            ::curl_multi_poll( multi( multi_ ), nullptr, 0, 1000, nullptr );
+        }
+        // what is left fails
+        {
+            std::lock_guard<std::mutex> _guard(mx_);
+            _incoming.swap( incoming_ );
+        }
+        for ( auto& _transfer : _incoming ) { finish_( std::move(_transfer), CURLE_ABORTED_BY_CALLBACK ); }
+        while ( !active_.empty() )
+        {
+            auto    _transfer(std::move(active_.begin()->second));
+            active_.erase( active_.begin() );
+            ::curl_multi_remove_handle( multi( multi_ ), _transfer->curl_ );
+            finish_( std::move(_transfer), CURLE_ABORTED_BY_CALLBACK );
+        }
+    }
+
+    void
+    AsyncAgent::start_( TransferPtr transfer )
+    {
+        CURL*   _curl;
+        if ( idle_.empty() ) { _curl = ::curl_easy_init(); }
+        else
+        {
+            _curl = idle_.back();
+            idle_.pop_back();
+            ::curl_easy_reset( _curl ); // keeps its connection and DNS caches (the multi's anyway)
+        }
+        transfer->curl_      = _curl;
+        transfer->errbuf_[0] = '\0';
+        for ( auto& _hdr : transfer->headers_ ) { transfer->lp_ = ::curl_slist_append( transfer->lp_, _hdr.c_str() ); }
+
+        ::curl_easy_setopt( _curl, CURLOPT_URL, transfer->url_.c_str() );
+        ::curl_easy_setopt( _curl, CURLOPT_ERRORBUFFER, transfer->errbuf_ );
+        ::curl_easy_setopt( _curl, CURLOPT_WRITEFUNCTION, &Transfer::on_data );
+        ::curl_easy_setopt( _curl, CURLOPT_WRITEDATA, transfer.get() );
+        ::curl_easy_setopt( _curl, CURLOPT_PRIVATE, transfer.get() );
+        ::curl_easy_setopt( _curl, CURLOPT_NOSIGNAL, 1L );
+        ::curl_easy_setopt( _curl, CURLOPT_TCP_KEEPALIVE, 1L );
+        ::curl_easy_setopt( _curl, CURLOPT_DNS_CACHE_TIMEOUT, options_.dnsSecs_ );
+        ::curl_easy_setopt( _curl, CURLOPT_TIMEOUT, options_.timeout_ );
+        if ( options_.http2_ )
+        {
+            ::curl_easy_setopt( _curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS );
+            ::curl_easy_setopt( _curl, CURLOPT_PIPEWAIT, 1L ); // rather a stream on a connection coming up than a new one
+        }
+        if ( transfer->post_ )
+        {
+            ::curl_easy_setopt( _curl, CURLOPT_POSTFIELDS, transfer->data_.data() );
+            ::curl_easy_setopt( _curl, CURLOPT_POSTFIELDSIZE_LARGE, curl_off_t(transfer->data_.size()) );
+        }
+        if ( transfer->lp_ ) { ::curl_easy_setopt( _curl, CURLOPT_HTTPHEADER, transfer->lp_ ); }
+
+        if ( ::curl_multi_add_handle( multi( multi_ ), _curl ) != CURLM_OK )
+        {
+            finish_( std::move(transfer), CURLE_FAILED_INIT );
+            return;
+        }
+        active_.emplace( _curl, std::move(transfer) );
+    }
+
+    void
+    AsyncAgent::reap_()
+    {
+        int         _left;
+        CURLMsg*    _msg;
+        while ( (_msg = ::curl_multi_info_read( multi( multi_ ), &_left )) )
+        {
+            if ( _msg->msg != CURLMSG_DONE ) { continue; }
+            CURLcode    _result(_msg->data.result);
+            auto        _itr(active_.find( _msg->easy_handle ));
+            ::curl_multi_remove_handle( multi( multi_ ), _msg->easy_handle );
+            if ( _itr == active_.end() ) { continue; }
+            auto        _transfer(std::move(_itr->second));
+            active_.erase( _itr );
+            finish_( std::move(_transfer), _result );
+        }
+    }
+
+    void
+    AsyncAgent::finish_( TransferPtr transfer, int result )
+    {
+        Response&   _resp(transfer->resp_);
+        _resp.result_ = result;
+        if ( CURL* _curl = transfer->curl_ )
+        {
+            char*   _type(nullptr);
+            ::curl_easy_getinfo( _curl, CURLINFO_RESPONSE_CODE, &_resp.code_ );
+            ::curl_easy_getinfo( _curl, CURLINFO_CONTENT_TYPE, &_type );
+            if ( _type ) { _resp.type_ = _type; }
+            idle_.push_back( _curl );
+        }
+        if ( result != CURLE_OK )
+        {
+            _resp.error_ = transfer->curl_ && transfer->errbuf_[0] ? transfer->errbuf_ : ::curl_easy_strerror( CURLcode(result) );
+        }
+        {
+            std::lock_guard<std::mutex> _guard(mx_);
+            --pending_;
+        }
+        if ( transfer->done_ ) { transfer->done_( std::move(_resp) ); }
+    }
+
+}} // namespace http, Utility
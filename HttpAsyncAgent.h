@@ -0,0 +1,119 @@
+/** ======================================================================+
+ + Copyright @2020-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#pragma once
+
+#ifndef UTILITY_HTTP_ASYNCAGENT_H
+#define UTILITY_HTTP_ASYNCAGENT_H
+
+#include "HttpAgent.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace Utility
+{
+namespace http
+{
+    /**
+     * @struct Response
+     * @brief The outcome of one AsyncAgent request.
+     */
+    struct Response
+    {
+        int         result_{0};  // CURLcode: 0 if the transfer went through
+        long        code_{0};    // HTTP status
+        std::string type_;       // Content-Type, if any
+        std::string body_;
+        std::string error_;
+
+        bool ok() const { return result_ == 0; }
+    };
+
+    /**
+     * @class AsyncAgent
+     * @brief Many requests in flight at once, over one curl multi handle
+     * driven by a thread of its own. Requests come from any thread, and
+     * complete through a callback (on the agent's thread: keep it short)
+     * or a future.
+     * The multi handle shares its connection and DNS caches among all
+     * requests: connections to a host are kept alive and reused, and
+     * HTTP/2 streams are multiplexed over one connection where the
+     * server agrees (https; libcurl no longer pipelines HTTP/1.1).
+     * Requests still pending at destruction complete, as failed.
+     */
+    class AsyncAgent
+    : Initializer
+    {
+        struct Transfer;
+        using TransferPtr = std::unique_ptr<Transfer>;
+        using Transfers   = std::vector<TransferPtr>;
+        using Active      = std::unordered_map<void*, TransferPtr>; // by CURL*
+        using Handles     = std::vector<void*>;                     // idle CURL*
+    public:
+        using Headers  = Agent::Headers;
+        using Callback = std::function<void(Response&&)>;
+
+        struct Options
+        {
+            long    hostConns_{8};     // per host (HTTP/1.1 keeps one request per connection)
+            long    totalConns_{64};
+            long    timeout_{0};       // seconds, per request; 0: none
+            long    dnsSecs_{60};      // DNS cache lifetime
+            bool    http2_{true};
+
+            Options& host_conns( long conns ) { hostConns_ = conns; return *this; }
+            Options& total_conns( long conns ) { totalConns_ = conns; return *this; }
+            Options& timeout( long timeout ) { timeout_ = timeout; return *this; }
+            Options& dns_secs( long secs ) { dnsSecs_ = secs; return *this; }
+            Options& http2( bool http2 ) { http2_ = http2; return *this; }
+        };
+
+        ~AsyncAgent() noexcept;
+        AsyncAgent() : AsyncAgent(Options()) {}
+        explicit
+        AsyncAgent(Options const& options);
+
+        void get( std::string const& url, Callback done, Headers const& headers = Headers() );
+        std::future<Response> get( std::string const& url, Headers const& headers = Headers() );
+
+        // default: "Content-Type: application/x-www-form-urlencoded"
+        void post( std::string const& url, std::string data, Callback done, char const* type = nullptr, Headers const& headers = Headers() );
+        std::future<Response> post( std::string const& url, std::string data, char const* type = nullptr, Headers const& headers = Headers() );
+
+        std::size_t pending() const; // submitted, not yet completed
+
+        // Rule of Five
+        AsyncAgent(AsyncAgent const&) = delete;
+        AsyncAgent& operator=( AsyncAgent const& ) = delete;
+
+    private:
+        Options             options_;
+        void*               multi_;  // CURLM*
+        mutable std::mutex  mx_;     // for incoming_, stopped_, pending_
+        Transfers           incoming_;
+        bool                stopped_{false};
+        std::size_t         pending_{0};
+        // the worker's own
+        Active              active_;
+        Handles             idle_;
+        std::thread         worker_;
+
+        void submit_( TransferPtr transfer );
+        void run_();
+        void start_( TransferPtr transfer );
+        void reap_();
+        void finish_( TransferPtr transfer, int result );
+    };
+
+}} // namespace http, Utility
+
+#endif // UTILITY_HTTP_ASYNCAGENT_H
@@ -9,7 +9,7 @@ namespace Utility
         static std::ostream& output( std::ostream& os, char const* function, char const* file, int line )
         {
             return line
-            ? (os << function_ << "@" << file << ":" << line)
+            ? (os << function << "@" << file << ":" << line)
             : (os << "(No location information)")
             ;            
         }
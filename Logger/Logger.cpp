@@ -3,8 +3,14 @@
 #include "Logger.h"
 #include "Lockable.h"
 #include "TimeStamp.h"
+#include "RotatingFile.h"
+#include "MappedLog.h"
+#include "Finally.h"
 
 #include <vector>
+#include <memory>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <algorithm>
@@ -35,14 +41,15 @@ namespace // underlying implementation, not exposed
         }
     }
 
+    //!> No std::endl: flushing is by policy (see LogManager)
     inline
-    void stream_print( std::ostream& os, std::ostringstream& msg, std::string const& timestamp, char const* strLevel )
+    void stream_print( std::ostream& os, char const* msg, std::size_t len, char const* timestamp, char const* strLevel )
     {
         os << timestamp
            << "|" << strLevel
            << "|" << std::setw(5) << ::syscall( SYS_gettid )
-           << "|" << msg.str()
-           << std::endl;
+           << "|";
+        os.write( msg, len ).put( '\n' );
     }
 
     /**
@@ -63,17 +70,19 @@ namespace // underlying implementation, not exposed
         
         bool is_named( char const* name ) const { return name_.compare( name ) == 0; }
 
-        void write_log( std::ostringstream& msg, std::string const& ts, char const* strLevel, ulong level )
+        void write_log( char const* msg, std::size_t len, char const* ts, char const* strLevel, ulong level )
         {
-            if ( mask_ & level ) { do_write( msg, ts, strLevel ); }
+            if ( mask_ & level ) { do_write( msg, len, ts, strLevel ); }
         }
-        
+
+        void flush() { do_flush(); }
         
     private:
         std::string     name_;
         ulong           mask_;
         
-        virtual void do_write( std::ostringstream& msg, std::string const& ts, char const* strLevel ) {}
+        virtual void do_write( char const* msg, std::size_t len, char const* ts, char const* strLevel ) {}
+        virtual void do_flush() {}
     };
     
     // Various subclass implemnentations
@@ -88,10 +97,12 @@ namespace // underlying implementation, not exposed
         {}
         
         virtual void
-        do_write( std::ostringstream& msg, std::string const& ts, char const* strLevel ) override
+        do_write( char const* msg, std::size_t len, char const* ts, char const* strLevel ) override
         {
-            stream_print( std::cerr, msg, ts, strLevel );
+            stream_print( std::cerr, msg, len, ts, strLevel );
         }
+
+        virtual void do_flush() override { std::cerr.flush(); }
     };
     
     // log to file
@@ -105,15 +116,64 @@ namespace // underlying implementation, not exposed
         {}
         
         virtual void
-        do_write( std::ostringstream& msg, std::string const& ts, char const* strLevel ) override
+        do_write( char const* msg, std::size_t len, char const* ts, char const* strLevel ) override
         {
-            stream_print( ofs_, msg, ts, strLevel );
+            stream_print( ofs_, msg, len, ts, strLevel );
         }
+
+        virtual void do_flush() override { ofs_.flush(); }
         
     private:
         std::ofstream   ofs_;
     };
     
+    // log to size/time rotated file
+    class RotatingLog
+    : public LoggerBase
+    {
+    public:
+        RotatingLog(std::string const& file, Utility::Rotation const& rotation, char const* tag = "Rotating", ulong mask = LEVEL_ALL)
+        : LoggerBase(tag, mask)
+        , file_(file.c_str(), rotation)
+        {}
+
+        virtual void
+        do_write( char const* msg, std::size_t len, char const* ts, char const* strLevel ) override
+        {
+            line_.reset();
+            stream_print( line_, msg, len, ts, strLevel );
+            file_.write( line_.data(), line_.size() );
+        }
+
+    private:
+        Utility::RotatingFile   file_;
+        LogBuffer               line_; // under LogManager lock
+    };
+
+    // log records to a memory mapped file
+    class MappedLogger
+    : public LoggerBase
+    {
+    public:
+        MappedLogger(std::string const& file, std::size_t capacity, unsigned keep, char const* tag = "Mapped", ulong mask = LEVEL_ALL)
+        : LoggerBase(tag, mask)
+        , log_(file.c_str(), capacity, keep)
+        {}
+
+        virtual void
+        do_write( char const* msg, std::size_t len, char const* ts, char const* strLevel ) override
+        {
+            line_.reset();
+            line_ << ts << "|" << strLevel << "|" << std::setw(5) << ::syscall( SYS_gettid ) << "|";
+            line_.write( msg, len );
+            log_.write( line_.data(), line_.size() );
+        }
+
+    private:
+        Utility::MappedLog  log_;
+        LogBuffer           line_; // under LogManager lock
+    };
+
     // log to stream
     class StreamLog
     : public LoggerBase
@@ -125,10 +185,12 @@ namespace // underlying implementation, not exposed
         {}
         
         virtual void
-        do_write( std::ostringstream& msg, std::string const& ts, char const* strLevel ) override
+        do_write( char const* msg, std::size_t len, char const* ts, char const* strLevel ) override
         {
-            stream_print( os_, msg, ts, strLevel );
+            stream_print( os_, msg, len, ts, strLevel );
         }
+
+        virtual void do_flush() override { os_.flush(); }
         
     private:
         std::ostream&   os_;
@@ -145,9 +207,9 @@ namespace // underlying implementation, not exposed
         {}
     
         virtual void
-        do_write( std::ostringstream& msg, std::string const& ts, char const* strLevel ) override
+        do_write( char const* msg, std::size_t len, char const* ts, char const* strLevel ) override
         {
-            functor_( msg.str().c_str(), ts.c_str(), strLevel );
+            functor_( msg, ts, strLevel );
         }
 
     private:
@@ -167,9 +229,9 @@ namespace // underlying implementation, not exposed
         {}
         
         virtual void
-        do_write( std::ostringstream& msg, std::string const& ts, char const* strLevel ) override
+        do_write( char const* msg, std::size_t len, char const* ts, char const* strLevel ) override
         {
-            callback_( context_, msg.str().c_str(), ts.c_str(), strLevel );
+            callback_( context_, msg, ts, strLevel );
         }
         
     private:
@@ -210,7 +272,6 @@ namespace // underlying implementation, not exposed
     public:
         LogManager()
         : loggers_()
-        , ts_()
         , reentry_(false)
         , first_(false)
         {
@@ -260,25 +321,64 @@ namespace // underlying implementation, not exposed
             } ), loggers_.end() );
         }
         
-        void write_log( std::ostringstream& msg, ulong level )
+        void write_log( LogBuffer& msg, ulong level )
         {
-            std::string const       _now(ts_.reset());
-            char const*             _level(log_level_string( level ));              
+            Utility::TimeStamp const    _now;
+            char const*                 _level(log_level_string( level ));
+            char const*                 _msg(msg.c_str());
             AUTORELOCK();
             if ( ToggleFalse _check{reentry_} )
             {
                 for ( auto logger : loggers_ )
                 {
-                    logger->write_log( msg, _now, _level, level );
+                    logger->write_log( _msg, msg.size(), _now.c_str(), _level, level );
                 }
+                if ( flush_due_( level ) ) { flush_(); }
             }
         }
+
+        void set_policy( std::size_t count, long millis, ulong levels )
+        {
+            AUTORELOCK();
+            count_  = count;
+            millis_ = Millis(millis > 0 ? millis : 0);
+            levels_ = levels;
+        }
+
+        void flush()
+        {
+            AUTORELOCK();
+            flush_();
+        }
         
     private:
+        using Clock  = std::chrono::steady_clock;
+        using Millis = std::chrono::milliseconds;
+
         std::vector<LoggerBase*>    loggers_;
-        Utility::TimeStamp          ts_;
         bool                        reentry_;
         bool                        first_;
+        // flush policy
+        std::size_t                 count_{64};
+        Millis                      millis_{1000};
+        ulong                       levels_{LEVEL_ERROR | LEVEL_FATAL};
+        std::size_t                 pending_{0};
+        Clock::time_point           flushed_{Clock::now()};
+
+        bool flush_due_( ulong level ) // under lock
+        {
+            ++pending_;
+            return (level & levels_)
+                || (count_ > 0 && pending_ >= count_)
+                || (millis_.count() > 0 && Clock::now() - flushed_ >= millis_);
+        }
+
+        void flush_() // under lock
+        {
+            for ( auto logger : loggers_ ) { logger->flush(); }
+            pending_ = 0;
+            flushed_ = Clock::now();
+        }
      };
      
     //avoid static initialization order disasters
@@ -287,16 +387,106 @@ namespace // underlying implementation, not exposed
         static LogManager   _manager;
         return _manager;
     }
+
+    /**
+     * Spare buffers, per thread. Entries made after the thread's pool is
+     * gone (e.g. from static destructors, which run after the main
+     * thread's thread_locals) get buffers of their own.
+     */
+    thread_local bool   sparesGone(false); // trivially destructible: readable to the end
+    struct Spares
+    {
+        std::vector<std::unique_ptr<LogBuffer>> buffers_;
+        ~Spares() noexcept { sparesGone = true; }
+    };
+    thread_local Spares spares;
     
 } // anonymous namespace
 
+// LogBuffer
+
+    char const*
+    LogBuffer::c_str()
+    {
+        if ( pptr() == epptr() ) { grow_( 1 ); }
+        *pptr() = '\0';
+        return pbase();
+    }
+
+    void
+    LogBuffer::reset()
+    {
+        if ( store_.size() > RETAINED )
+        {
+            store_.resize( INITIAL );
+            store_.shrink_to_fit();
+        }
+        setp( store_.data(), store_.data() + store_.size() );
+        clear();
+        flags( std::ios_base::dec | std::ios_base::skipws );
+        precision( 6 );
+        width( 0 );
+        fill( ' ' );
+    }
+
+    void
+    LogBuffer::grow_( std::size_t extra )
+    {
+        std::size_t _used(size());
+        store_.resize( std::max( 2 * store_.size(), _used + extra ) );
+        setp( store_.data(), store_.data() + store_.size() );
+        pbump( static_cast<int>(_used) );
+    }
+
+    LogBuffer::int_type
+    LogBuffer::overflow( int_type c )
+    {
+        if ( traits_type::eq_int_type( c, traits_type::eof() ) ) { return traits_type::not_eof( c ); }
+        grow_( 1 );
+        *pptr() = traits_type::to_char_type( c );
+        pbump( 1 );
+        return c;
+    }
+
+    std::streamsize
+    LogBuffer::xsputn( char const* str, std::streamsize len )
+    {
+        if ( epptr() - pptr() < len ) { grow_( len ); }
+        ::memcpy( pptr(), str, len );
+        pbump( static_cast<int>(len) );
+        return len;
+    }
+
 // API Section
 
+    LogBuffer*
+    LogStream::acquire_()
+    {
+        if ( sparesGone || spares.buffers_.empty() ) { return new LogBuffer; }
+        LogBuffer*  _buf(spares.buffers_.back().release());
+        spares.buffers_.pop_back();
+        return _buf;
+    }
+
+    void
+    LogStream::release_( LogBuffer* buf ) noexcept
+    {
+        std::unique_ptr<LogBuffer>  _buf(buf); // deleted, unless pooled
+        if ( sparesGone ) { return; }
+        try
+        {
+            _buf->reset();
+            spares.buffers_.push_back( std::move(_buf) );
+        }
+        catch (...) {}
+    }
+
     LogStream::~LogStream() noexcept
     {
+        Utility::Finally    _release([this]() { release_( buf_ ); }); // whatever write_log does
         try
         {
-            log_manager().write_log( oss_, level_ );
+            log_manager().write_log( *buf_, level_ );
         }
         catch (...) {}
     }
@@ -306,6 +496,16 @@ namespace // underlying implementation, not exposed
         log_manager().add_logger( new FileLog( file, tag, mask ) );
     }
     
+    void LogStream::add_rotating_logger( char const* file, Utility::Rotation const& rotation, ulong mask, char const* tag )
+    {
+        log_manager().add_logger( new RotatingLog( file, rotation, tag, mask ) );
+    }
+
+    void LogStream::add_mapped_logger( char const* file, std::size_t capacity, ulong mask, char const* tag, unsigned keep )
+    {
+        log_manager().add_logger( new MappedLogger( file, capacity, keep, tag, mask ) );
+    }
+
     void LogStream::add_stream_logger( std::ostream& stream, ulong mask, char const* tag )
     {
         log_manager().add_logger( new StreamLog( stream, tag, mask ) );
@@ -331,5 +531,15 @@ namespace // underlying implementation, not exposed
         log_manager().keep_logger();
     }
 
+    void LogStream::set_flush_policy( std::size_t count, long millis, ulong levels )
+    {
+        log_manager().set_policy( count, millis, levels );
+    }
+
+    void LogStream::flush()
+    {
+        log_manager().flush();
+    }
+
 
 } // namespace Log
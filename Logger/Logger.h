@@ -16,8 +16,8 @@
      * Supported levels are: Debug, Info, Warn, Error, and Fatal.
      *
      * DebugLog, InfoLog, WarnLog, ErrorLog and FatalLog are macros that 
-     * expose a std::ostringstream - which is why the stream insertion 
-     * syntax works - member of a temporary wrapper object.  When the 
+     * expose a std::ostream - which is why the stream insertion 
+     * syntax works - borrowed by a temporary wrapper object.  When the 
      * object goes out of scope at the end of the statement, the dtor
      * takes care of committing the log entry to an underlying thread
      * safe implementation.  This also means that a logger can be passed
@@ -25,9 +25,13 @@
      */
 
 #include "Location.h"
-#include <sstream>
+#include <ostream>
+#include <streambuf>
+#include <vector>
 #include <functional>
 
+namespace Utility { struct Rotation; } // @see RotatingFile.h
+
 namespace Log
 {
 
@@ -47,12 +51,47 @@ namespace Log
         EVENT_LOGGING = LEVEL_ERROR & LEVEL_FATAL
     };
     
-    using Utility::Location;
+    using Location = Utility::Location<>;
     
     
+    /**
+     * LogBuffer:
+     * Growable character buffer with an ostream facade. Reused: each
+     * thread keeps a few (nested entries, e.g. logging from inside an
+     * inserter, just take another one).
+     */
+    class LogBuffer
+    : private std::streambuf
+    , public std::ostream
+    {
+    public:
+        LogBuffer()
+        : std::ostream(static_cast<std::streambuf*>(this))
+        , store_(INITIAL)
+        {
+            reset();
+        }
+
+        char const* data() const { return pbase(); }
+        std::size_t size() const { return pptr() - pbase(); }
+        char const* c_str(); // terminated, not counted
+
+        void reset(); // empty, default formatting
+
+    private:
+        using int_type    = std::streambuf::int_type;
+        using traits_type = std::streambuf::traits_type;
+        enum { INITIAL = 256, RETAINED = 65536 };
+        std::vector<char>   store_;
+
+        void grow_( std::size_t extra );
+        int_type overflow( int_type c ) override;
+        std::streamsize xsputn( char const* str, std::streamsize len ) override;
+    };
+
     /**
      * LogStream:
-     * Accumulate items into a local stringstream buffer until end 
+     * Accumulate items into a borrowed per-thread buffer until end 
      * of scope, when dtor will commit the entry to the underlying 
      * threadsafe API.
      */
@@ -61,24 +100,31 @@ namespace Log
     public:
         using ulong = unsigned long;
         LogStream(Location const& location, ulong level)
-        : oss_()
+        : buf_(acquire_())
         , level_(level)
         {
-            oss_ << location << "|";
+            *buf_ << location << "|";
         }
         
         LogStream(ulong level)
-        : oss_()
+        : buf_(acquire_())
         , level_(level)
         {}
         
         ~LogStream() noexcept; // all the action is here
+
+        // buf_ is borrowed from the pool: a copy would return it twice
+        LogStream(LogStream const&) = delete;
+        LogStream& operator=( LogStream const& ) = delete;
         
         // see macros below
-        std::ostream& log() { return oss_; }
+        std::ostream& log() { return *buf_; }
         
         // management API: the optional tag is for identification and/or grouping.
         static void add_file_logger( char const* file, ulong mask = FILE_LOGGING, char const* tag = "File" );
+        static void add_rotating_logger( char const* file, Utility::Rotation const& rotation, ulong mask = FILE_LOGGING, char const* tag = "Rotating" );
+        // crash-safe: entries are records in a mapped file (@see MappedLog.h); keep: rolled segments retained (0: all)
+        static void add_mapped_logger( char const* file, std::size_t capacity, ulong mask = FILE_LOGGING, char const* tag = "Mapped", unsigned keep = 0 );
         static void add_stream_logger( std::ostream& stream, ulong mask = FILE_LOGGING, char const* tag = "Stream" );
         
         // delegation to user defined logging methods
@@ -94,10 +140,19 @@ namespace Log
         // it is disabled by default when another logger is enabled from the app level, unless
         // this is called first to keep the default logger.
         static void keep_default_logger();
+
+        // stream/file loggers are flushed when any condition is met (zero disables one):
+        // after 'count' entries, after 'millis' since the last flush (checked on the next
+        // entry), or on an entry whose level is in 'levels'. Default: 64, 1000, ERROR|FATAL.
+        static void set_flush_policy( std::size_t count, long millis, ulong levels = LEVEL_ERROR | LEVEL_FATAL );
+        static void flush();
         
     private:
-        std::ostringstream      oss_;
-        ulong                   level_;
+        LogBuffer*      buf_;
+        ulong           level_;
+
+        static LogBuffer* acquire_();
+        static void release_( LogBuffer* ) noexcept;
     };
     
     class NullStream
@@ -134,7 +189,7 @@ LOGGER_DECL Log::NullStream     FatalLog0;
 
 #else
 
-#define LOCATION()  Utility::Location(__FUNCTION__, __FILE__, __LINE__)
+#define LOCATION()  Log::Location(__FUNCTION__, __FILE__, __LINE__)
 
 #define DebugLog    Log::LogStream(LOCATION(), Log::LEVEL_DEBUG).log()
 #define InfoLog     Log::LogStream(LOCATION(), Log::LEVEL_INFO).log()
@@ -2,8 +2,15 @@
 #include "LogImpl.h"
 #include "CharBuffer.h"
 #include "TimeFns.h"
+#include "RotatingFile.h"
+#include "Record.h"
 
 #include <map>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
 #include <sstream>
 #include <fstream>
 #include <iostream>
@@ -48,11 +55,11 @@ namespace Utility
     Logger::Logger(char const* name, Log::Level level)
     : name_(name)
     , impl_(LogImpl::acquire_pimpl( name, level ))
-    , level_(impl_ ? LogImpl::get_level( impl_ ) : level)
+    , level_(static_cast<uint32_t>(impl_ ? LogImpl::get_level( impl_ ) : level))
     {}
 
     Log::Token
-    Logger::is_active( Log::Level level ) const
+    Logger::consult_( Log::Level level ) const
     {
         auto    _tok(LogImpl::is_active( impl_, level ));
         return {_tok, (_tok == nullptr ? Log::Level::OFF : level)};
@@ -61,7 +68,14 @@ namespace Utility
     Logger&
     Logger::set_level( Log::Level level )
     {
-        level_ = LogImpl::set_level( impl_, level );
+        level_.store( static_cast<uint32_t>(LogImpl::set_level( impl_, level )), std::memory_order_relaxed );
+        return *this;
+    }
+
+    Logger&
+    Logger::refresh()
+    {
+        if ( impl_ ) { level_.store( static_cast<uint32_t>(LogImpl::get_level( impl_ )), std::memory_order_relaxed ); }
         return *this;
     }
 
@@ -69,6 +83,7 @@ namespace Utility
     {
         std::ofstream   ofs;
         std::ostream*   outp = &std::cerr;
+        std::unique_ptr<RotatingFile>   rotp; // takes precedence over outp
 
 #define STR2ENUM(lvl, ...)  { #lvl, Log::Level::lvl },
 
@@ -82,14 +97,22 @@ namespace Utility
         {
             LocalTime   _now;
             // Format: Timestamp|Level|ID|Message (Location)
-            *outp << Utility::CharBuffer<2048>("%4d-%02d-%02dT%02d:%02d:%02d.%06ld|%5s|%6d|%s (%s@%s:%d)\n"
+            Utility::CharBuffer<2048>   _entry("%4d-%02d-%02dT%02d:%02d:%02d.%06ld|%5s|%6d|%s (%s@%s:%d)\n"
                 , (_now.tm_.tm_year + 1900), (_now.tm_.tm_mon + 1), _now.tm_.tm_mday
                 , _now.tm_.tm_hour, _now.tm_.tm_min, _now.tm_.tm_sec, (_now.ts_.tv_nsec /1000)
                 , level
                 , ::syscall( SYS_gettid )
                 , msg
-                , loc.func_, loc.file_, loc.line_)
-                .get();
+                , loc.func_, loc.file_, loc.line_);
+            if ( rotp ) { rotp->write( _entry.get(), _entry.size() ); }
+            else { *outp << _entry.get(); }
+        }
+
+        void default_commit( char const* level, Location const& loc, Record const& record, bool json )
+        {
+            char    _msg[2048];
+            record.render( _msg, sizeof(_msg), json ? Record::Format::JSON : Record::Format::LOGFMT );
+            default_commit( level, loc, _msg );
         }
     } // namespace anonymous
 
@@ -107,6 +130,7 @@ namespace Utility
         if ( filename )
         {
             // Should improve this to use direct swap.
+            rotp.reset();
             ofs.close();
             ofs.open( filename, append ? std::ios_base::out | std::ios_base::app : std::ios_base::out );
             if ( ofs )
@@ -119,12 +143,25 @@ namespace Utility
         }
         else // restore default
         {
+            rotp.reset();
             ofs.close();
             outp = &std::cerr;
         }
         return true;
     }
 
+    bool
+    Log::set_rotating_log( char const* filename, Rotation const& rotation )
+    {
+        if ( !filename ) { return set_default_log( nullptr, false ); }
+        std::unique_ptr<RotatingFile>   _rotp(new RotatingFile(filename, rotation));
+        if ( !*_rotp ) { return false; } // keep current destination
+        ofs.close();
+        outp = &std::cerr;
+        rotp = std::move(_rotp);
+        return true;
+    }
+
     bool
     Log::set_log_level( std::string const& level )
     {
@@ -147,6 +184,259 @@ namespace Utility
         }
     }
 
+    //!> The record goes to the sink as is: rendering is the sink's business
+    void
+    Log::commit( Log::Token const& token, Location const& loc, Record const& record )
+    {
+        if ( token.impl_ )
+        {
+            LogImpl::commit( token.impl_, token.level_, loc, record );
+        }
+        else
+        {
+            default_commit( level_string( token.level_ ), loc, record, recordJson );
+        }
+    }
+
     Log::Level Log::globalLevel = Log::Level::INFO;
+    bool       Log::recordJson  = false;
+
+//==========================================================================
+    namespace
+    {
+        /**
+         * Bounded appender: keeps counting past the end, like snprintf.
+         */
+        struct Out
+        {
+            char*       buf_;
+            std::size_t cap_;
+            std::size_t len_{0};
+
+            Out& put( char c )
+            {
+                if ( len_ + 1 < cap_ ) { buf_[len_] = c; }
+                ++len_;
+                return *this;
+            }
+
+            Out& put( char const* str, std::size_t len )
+            {
+                if ( len_ + 1 < cap_ ) { ::memcpy( buf_ + len_, str, std::min( len, cap_ - len_ - 1 ) ); }
+                len_ += len;
+                return *this;
+            }
+
+            Out& put( char const* str ) { return put( str, ::strlen( str ) ); }
+
+            template<typename... Args>
+            Out& fmt( char const* fmt, Args... args )
+            {
+                char    _tmp[64];
+                int     _len(::snprintf( _tmp, sizeof(_tmp), fmt, args... ));
+                return put( _tmp, _len < 0 ? 0 : std::min( std::size_t(_len), sizeof(_tmp) - 1 ) );
+            }
+
+            std::size_t done()
+            {
+                if ( cap_ > 0 ) { buf_[std::min( len_, cap_ - 1 )] = '\0'; }
+                return len_;
+            }
+        };
+
+        bool needs_quotes( char const* ptr, std::size_t len )
+        {
+            if ( len == 0 ) { return true; }
+            for ( auto _end(ptr + len); ptr < _end; ++ptr )
+            {
+                if ( *ptr <= ' ' || *ptr == '=' || *ptr == '"' || *ptr == '\\' ) { return true; }
+            }
+            return false;
+        }
+
+        void put_escaped( Out& out, char const* ptr, std::size_t len )
+        {
+            for ( auto _end(ptr + len); ptr < _end; ++ptr )
+            {
+                switch ( *ptr )
+                {
+                case '"':  out.put( "\\\"", 2 ); break;
+                case '\\': out.put( "\\\\", 2 ); break;
+                case '\n': out.put( "\\n", 2 ); break;
+                case '\r': out.put( "\\r", 2 ); break;
+                case '\t': out.put( "\\t", 2 ); break;
+                default:
+                    if ( static_cast<unsigned char>(*ptr) < ' ' ) { out.fmt( "\\u%04x", unsigned(*ptr) ); }
+                    else { out.put( *ptr ); }
+                }
+            }
+        }
+
+        //!> JSON keys are escaped; logfmt keys cannot be quoted, so what would break them becomes '_'
+        void put_key( Out& out, char const* key, std::size_t len, bool json )
+        {
+            if ( json )
+            {
+                out.put( ",\"" );
+                put_escaped( out, key, len );
+                out.put( "\":", 2 );
+                return;
+            }
+            out.put( ' ' );
+            for ( auto _end(key + len); key < _end; ++key )
+            {
+                out.put( (*key <= ' ' || *key == '=' || *key == '"' || *key == '\\') ? '_' : *key );
+            }
+            out.put( '=' );
+        }
+
+        void put_time( Out& out, int64_t nanos )
+        {   // RFC 3339, UTC
+            time_t      _secs(nanos / 1000000000LL);
+            struct tm   _tm;
+            ::gmtime_r( &_secs, &_tm );
+            out.fmt( "%4d-%02d-%02dT%02d:%02d:%02d.%06ldZ"
+                , (_tm.tm_year + 1900), (_tm.tm_mon + 1), _tm.tm_mday
+                , _tm.tm_hour, _tm.tm_min, _tm.tm_sec, long((nanos % 1000000000LL) / 1000) );
+        }
+
+        //!> JSON has no NaN or infinities: those go as strings
+        void put_real( Out& out, double real, bool json )
+        {
+            if ( std::isfinite( real ) ) { out.fmt( "%.17g", real ); }
+            else if ( std::isnan( real ) ) { out.put( json ? "\"NaN\"" : "NaN" ); }
+            else if ( real > 0 ) { out.put( json ? "\"+Inf\"" : "+Inf" ); }
+            else { out.put( json ? "\"-Inf\"" : "-Inf" ); }
+        }
+
+        void put_value( Out& out, Field const& field, bool json )
+        {
+            switch ( field.type_ )
+            {
+            case Field::Type::INT:  out.fmt( "%lld", static_cast<long long>(field.int_) ); break;
+            case Field::Type::UINT: out.fmt( "%llu", static_cast<unsigned long long>(field.uint_) ); break;
+            case Field::Type::REAL: put_real( out, field.real_, json ); break;
+            case Field::Type::BOOL: out.put( field.bool_ ? "true" : "false" ); break;
+            case Field::Type::TIME:
+                out.put( '"' );
+                put_time( out, field.time_ );
+                out.put( '"' );
+                break;
+            case Field::Type::TEXT:
+                if ( json || needs_quotes( field.text_.ptr_, field.text_.len_ ) )
+                {
+                    out.put( '"' );
+                    put_escaped( out, field.text_.ptr_, field.text_.len_ );
+                    out.put( '"' );
+                }
+                else { out.put( field.text_.ptr_, field.text_.len_ ); }
+                break;
+            }
+        }
+
+        void put_msg( Out& out, char const* msg, std::size_t len, bool json )
+        {
+            out.put( json ? "{\"msg\":" : "msg=" );
+            put_value( out, Field("msg", msg, len), json );
+        }
+
+        /**
+         * pack() layout, native byte order (the copy does not leave the process):
+         *   [u32 msg length][msg]
+         *   then per field: [u8 type][u16 key length][key][value]
+         *   where a value is 8 bytes, or [u32 length][bytes] for TEXT.
+         */
+        template<typename T>
+        void append( std::string& out, T value ) { out.append( reinterpret_cast<char const*>(&value), sizeof(value) ); }
+
+        template<typename T>
+        T extract( char const*& ptr )
+        {
+            T   _value;
+            ::memcpy( &_value, ptr, sizeof(_value) );
+            ptr += sizeof(_value);
+            return _value;
+        }
+    } // namespace anonymous
+
+    std::size_t
+    Record::render( char* buf, std::size_t cap, Format format ) const
+    {
+        Out     _out{buf, cap};
+        bool    _json(format == Format::JSON);
+
+        put_msg( _out, msg_ ? msg_ : "", msg_ ? ::strlen( msg_ ) : 0, _json );
+        for ( auto _ptr(fields_), _end(fields_ + count_); _ptr < _end; ++_ptr )
+        {
+            put_key( _out, _ptr->key_, ::strlen( _ptr->key_ ), _json );
+            put_value( _out, *_ptr, _json );
+        }
+        if ( _json ) { _out.put( '}' ); }
+        return _out.done();
+    }
+
+    void
+    Record::pack( std::string& out ) const
+    {
+        std::size_t _msg(msg_ ? ::strlen( msg_ ) : 0);
+        append( out, uint32_t(_msg) );
+        out.append( msg_ ? msg_ : "", _msg );
+        for ( auto _ptr(fields_), _end(fields_ + count_); _ptr < _end; ++_ptr )
+        {
+            std::size_t _key(std::min( ::strlen( _ptr->key_ ), std::size_t(UINT16_MAX) ));
+            append( out, uint8_t(_ptr->type_) );
+            append( out, uint16_t(_key) );
+            out.append( _ptr->key_, _key );
+            if ( _ptr->type_ == Field::Type::TEXT )
+            {
+                std::size_t _len(std::min( _ptr->text_.len_, std::size_t(UINT32_MAX) ));
+                append( out, uint32_t(_len) );
+                out.append( _ptr->text_.ptr_, _len );
+            }
+            else if ( _ptr->type_ == Field::Type::BOOL ) { append( out, uint64_t(_ptr->bool_) ); }
+            else { append( out, _ptr->uint_ ); } // all 8 bytes of the union
+        }
+    }
+
+    std::size_t
+    Record::render( char const* packed, std::size_t len, char* buf, std::size_t cap, Format format )
+    {
+        Out         _out{buf, cap};
+        bool        _json(format == Format::JSON);
+        char const* _ptr(packed);
+        char const* _end(packed + len);
+
+        uint32_t    _msg(extract<uint32_t>( _ptr ));
+        put_msg( _out, _ptr, _msg, _json );
+        _ptr += _msg;
+        while ( _ptr < _end )
+        {
+            auto        _type(Field::Type(extract<uint8_t>( _ptr )));
+            uint16_t    _key(extract<uint16_t>( _ptr ));
+            put_key( _out, _ptr, _key, _json );
+            _ptr += _key;
+
+            Field       _field("", false);
+            switch ( _type )
+            {
+            case Field::Type::TEXT:
+            {
+                uint32_t    _len(extract<uint32_t>( _ptr ));
+                _field = Field("", _ptr, _len);
+                _ptr  += _len;
+                break;
+            }
+            case Field::Type::BOOL:
+                _field = Field("", extract<uint64_t>( _ptr ) != 0);
+                break;
+            default:
+                _field.uint_ = extract<uint64_t>( _ptr );
+                _field.type_ = _type;
+            }
+            put_value( _out, _field, _json );
+        }
+        if ( _json ) { _out.put( '}' ); }
+        return _out.done();
+    }
 } // namespace Utility
 
@@ -5,6 +5,7 @@
 
 #include <cstdint>
 #include <ostream>
+#include <atomic>
 
     /**
      * @file Log.h
@@ -55,7 +56,15 @@ namespace Utility
 
 #define ENUMLEVEL(lvl, ...)     lvl,
 
+// Compile-time floor: macro invocations below it compile to nothing.
+// Values follow Log::Level: 0 ALL, 1 DEBUG, 2 INFO, 3 WARN, 4 ERROR, 5 FATAL
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL   0
+#endif
+
     class Logger; // forward declaration to untangle mutual dependencies
+    struct Rotation; // @see RotatingFile.h
+    struct Record;   // @see Record.h
 
     class Log
     {
@@ -86,6 +95,7 @@ namespace Utility
         static Token is_active( Logger const*, Log::Level ); 
         static Token is_active( Logger const&, Log::Level );
         //
+        static constexpr bool compiled_in( Level lvl ) { return static_cast<uint32_t>(lvl) >= LOG_MIN_LEVEL; }
         static Level get_global_level() { return globalLevel; }
         static bool set_log_level( std::string const& lvl );
         static void set_global_level( Level lvl ) { globalLevel = lvl; }
@@ -94,10 +104,15 @@ namespace Utility
         //
         static bool set_unique_log( char const* basename, char const* dir = "/tmp" );
         static bool set_default_log( char const* filename, bool append );
+        static bool set_rotating_log( char const* filename, Rotation const& rotation );
         static void commit( Token const&, Location const&, char const* );
+        // structured entries: rendered as logfmt (default) or JSON
+        static void commit( Token const&, Location const&, Record const& );
+        static void set_record_json( bool json ) { recordJson = json; }
 
     private:
         static Level    globalLevel;
+        static bool     recordJson;
     };
 
 //==========================================================================
@@ -110,16 +125,30 @@ namespace Utility
         Logger(char const* name, Log::Level level);
 
         Logger& set_level( Log::Level lvl ); // { level_ = lvl; return *this; }
+        Logger& refresh(); // re-read level, if changed behind our back in the back end
 
-        Log::Token is_active( Log::Level lvl ) const;
+        //!> Disabled levels cost a load and a branch; the back end sees only the rest.
+        Log::Token is_active( Log::Level lvl ) const
+        {
+            return static_cast<uint32_t>(lvl) < level_.load( std::memory_order_relaxed )
+            ? Log::Token()
+            : consult_( lvl );
+        }
 
     private:
+        using Cached = std::atomic<uint32_t>; // Log::Level, as loaded on every check
+
         char const*     name_;
         void*           impl_{nullptr}; // implementation
-        Log::Level      level_;
+        Cached          level_;
         friend class Log;
+
+        Log::Token consult_( Log::Level lvl ) const;
     };
 
+    static_assert(static_cast<uint32_t>(Log::Level::DEBUG) == 1 && static_cast<uint32_t>(Log::Level::FATAL) == 5
+                 , "LOG_MIN_LEVEL values must follow Log::Level");
+
 //==========================================================================
 
     inline Log::Token
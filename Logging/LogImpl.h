@@ -4,6 +4,7 @@
 #define LOGIMPL_H
 
 #include "Log.h"
+#include "Record.h"
 
 namespace LogImpl
 {
@@ -19,6 +20,8 @@ namespace LogImpl
 	using Tok = void*;
 	extern Tok is_active( void* pimpl, Utility::Log::Level level );
 	extern void commit( Tok tok, Utility::Log::Level level, Utility::Location const& loc, char const* msg );
+	// structured: valid for the call only (Record::pack() keeps a copy), rendered as the back end sees fit
+	extern void commit( Tok tok, Utility::Log::Level level, Utility::Location const& loc, Utility::Record const& record );
 } // namespace LogImpl
 
 #endif //  LOGIMPL_H
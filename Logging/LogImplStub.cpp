@@ -16,5 +16,6 @@ namespace LogImpl
 	Utility::Log::Level set_level( void*, Utility::Log::Level level ) { return level; }
 	void* is_active( void* ptr, Utility::Log::Level level ) { return ptr; }
 	void commit( void*, Utility::Log::Level, Utility::Location const&, char const* ) {}
+	void commit( void*, Utility::Log::Level, Utility::Location const&, Utility::Record const& ) {}
 
 } // namespace LogImpl
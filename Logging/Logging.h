@@ -7,19 +7,50 @@
 
 #define LOCATION()  Utility::Location({__FUNCTION__, Utility::base_name(__FILE__), __LINE__})
 
+// Level-specific macros below LOG_MIN_LEVEL (see Log.h) expand to nothing at all:
+// their arguments are not even compiled. The generic macros test
+// Log::compiled_in(), which the optimizer folds away for constant levels.
+#define LOG_ELIDED(...)     do {} while ( false )
+#define LOG_KEPT(...)       __VA_ARGS__
+#if LOG_MIN_LEVEL > 1
+#define LOG_AT_DEBUG        LOG_ELIDED
+#else
+#define LOG_AT_DEBUG        LOG_KEPT
+#endif
+#if LOG_MIN_LEVEL > 2
+#define LOG_AT_INFO         LOG_ELIDED
+#else
+#define LOG_AT_INFO         LOG_KEPT
+#endif
+#if LOG_MIN_LEVEL > 3
+#define LOG_AT_WARN         LOG_ELIDED
+#else
+#define LOG_AT_WARN         LOG_KEPT
+#endif
+#if LOG_MIN_LEVEL > 4
+#define LOG_AT_ERROR        LOG_ELIDED
+#else
+#define LOG_AT_ERROR        LOG_KEPT
+#endif
+#if LOG_MIN_LEVEL > 5
+#define LOG_AT_FATAL        LOG_ELIDED
+#else
+#define LOG_AT_FATAL        LOG_KEPT
+#endif
+
 // For message construction using insertion syntax. Example:
 //    LOG_STREAM(logger, Utility::Log::Level::INFO, "my message: " << myarg);
 //
 #define LOG_STREAM(L, P, X) \
-    do if ( Utility::Log::Token _token{Utility::Log::is_active( L, P )} ) { \
+    do if ( Utility::Log::compiled_in( P ) ) if ( Utility::Log::Token _token{Utility::Log::is_active( L, P )} ) { \
         LOG_COMMIT_STREAM(_token, X); \
     } while ( false )
 
-#define LOG_STRM_DEBUG(L, X) LOG_STREAM(L, Utility::Log::Level::DEBUG, X)
-#define LOG_STRM_INFO(L, X)  LOG_STREAM(L, Utility::Log::Level::INFO, X)
-#define LOG_STRM_WARN(L, X)  LOG_STREAM(L, Utility::Log::Level::WARN, X)
-#define LOG_STRM_ERROR(L, X) LOG_STREAM(L, Utility::Log::Level::ERROR, X)
-#define LOG_STRM_FATAL(L, X) LOG_STREAM(L, Utility::Log::Level::FATAL, X)
+#define LOG_STRM_DEBUG(L, X) LOG_AT_DEBUG(LOG_STREAM(L, Utility::Log::Level::DEBUG, X))
+#define LOG_STRM_INFO(L, X)  LOG_AT_INFO(LOG_STREAM(L, Utility::Log::Level::INFO, X))
+#define LOG_STRM_WARN(L, X)  LOG_AT_WARN(LOG_STREAM(L, Utility::Log::Level::WARN, X))
+#define LOG_STRM_ERROR(L, X) LOG_AT_ERROR(LOG_STREAM(L, Utility::Log::Level::ERROR, X))
+#define LOG_STRM_FATAL(L, X) LOG_AT_FATAL(LOG_STREAM(L, Utility::Log::Level::FATAL, X))
 
 // Token can be pre-acquired for multiple calls
 #define LOG_STREAM_IF(T, X)   \
@@ -31,15 +62,15 @@
 //    LOG_FORMAT(logger, Utility::Log::Level::INFO, "my message: %s", myarg);
 //
 #define LOG_FORMAT(L, P, ...) \
-    do if ( Utility::Log::Token _token{Utility::Log::is_active( L, P )} ) { \
+    do if ( Utility::Log::compiled_in( P ) ) if ( Utility::Log::Token _token{Utility::Log::is_active( L, P )} ) { \
         LOG_COMMIT_FORMAT(_token, __VA_ARGS__); \
     } while ( false )
 
-#define LOG_FMT_DEBUG(L, ...) LOG_FORMAT(L, Utility::Log::Level::DEBUG, __VA_ARGS__)
-#define LOG_FMT_INFO(L, ...)  LOG_FORMAT(L, Utility::Log::Level::INFO, __VA_ARGS__)
-#define LOG_FMT_WARN(L, ...)  LOG_FORMAT(L, Utility::Log::Level::WARN, __VA_ARGS__)
-#define LOG_FMT_ERROR(L, ...) LOG_FORMAT(L, Utility::Log::Level::ERROR, __VA_ARGS__)
-#define LOG_FMT_FATAL(L, ...) LOG_FORMAT(L, Utility::Log::Level::FATAL, __VA_ARGS__)
+#define LOG_FMT_DEBUG(L, ...) LOG_AT_DEBUG(LOG_FORMAT(L, Utility::Log::Level::DEBUG, __VA_ARGS__))
+#define LOG_FMT_INFO(L, ...)  LOG_AT_INFO(LOG_FORMAT(L, Utility::Log::Level::INFO, __VA_ARGS__))
+#define LOG_FMT_WARN(L, ...)  LOG_AT_WARN(LOG_FORMAT(L, Utility::Log::Level::WARN, __VA_ARGS__))
+#define LOG_FMT_ERROR(L, ...) LOG_AT_ERROR(LOG_FORMAT(L, Utility::Log::Level::ERROR, __VA_ARGS__))
+#define LOG_FMT_FATAL(L, ...) LOG_AT_FATAL(LOG_FORMAT(L, Utility::Log::Level::FATAL, __VA_ARGS__))
 
 // Token can be pre-acquired for multiple calls
 #define LOG_FORMAT_IF(T, ...)   \
@@ -47,6 +78,29 @@
         LOG_COMMIT_FORMAT(T, __VA_ARGS__); \
     } while ( false )
 
+// For structured entries: typed fields, rendered as logfmt or JSON. Example:
+//    LOG_FIELDS(logger, Utility::Log::Level::INFO, "order filled",
+//               Utility::kv("id", id), Utility::kv("px", px), Utility::kv("at", Utility::Stamp::now()));
+// String fields are captured by reference, so must outlive the statement (they do, as arguments).
+// The fields may be left out: LOG_KV_INFO(logger, "started").
+//
+#define LOG_FIELDS(L, P, M, ...) \
+    do if ( Utility::Log::compiled_in( P ) ) if ( Utility::Log::Token _token{Utility::Log::is_active( L, P )} ) { \
+        LOG_COMMIT_FIELDS(_token, M, __VA_ARGS__); \
+    } while ( false )
+
+#define LOG_KV_DEBUG(L, M, ...) LOG_AT_DEBUG(LOG_FIELDS(L, Utility::Log::Level::DEBUG, M, __VA_ARGS__))
+#define LOG_KV_INFO(L, M, ...)  LOG_AT_INFO(LOG_FIELDS(L, Utility::Log::Level::INFO, M, __VA_ARGS__))
+#define LOG_KV_WARN(L, M, ...)  LOG_AT_WARN(LOG_FIELDS(L, Utility::Log::Level::WARN, M, __VA_ARGS__))
+#define LOG_KV_ERROR(L, M, ...) LOG_AT_ERROR(LOG_FIELDS(L, Utility::Log::Level::ERROR, M, __VA_ARGS__))
+#define LOG_KV_FATAL(L, M, ...) LOG_AT_FATAL(LOG_FIELDS(L, Utility::Log::Level::FATAL, M, __VA_ARGS__))
+
+// Token can be pre-acquired for multiple calls
+#define LOG_FIELDS_IF(T, M, ...)   \
+    do if ( T ) { \
+        LOG_COMMIT_FIELDS(T, M, __VA_ARGS__); \
+    } while ( false )
+
 // Commit implementations
 #include <sstream>
 #define LOG_COMMIT_STREAM(T, X) \
@@ -59,4 +113,8 @@
     using Log_Buffer = Utility::CharBuffer<2048>; \
     Utility::Log::commit( T, LOCATION(), Log_Buffer(__VA_ARGS__).get() )
 
+#include "Record.h"
+#define LOG_COMMIT_FIELDS(T, M, ...) \
+    Utility::Log::commit( T, LOCATION(), Utility::Record(M, { __VA_ARGS__ }) )
+
 #endif // UTILITY_LOGGING_H
@@ -0,0 +1,129 @@
+#pragma once
+
+#ifndef UTILITY_RECORD_H
+#define UTILITY_RECORD_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <initializer_list>
+#include <chrono>
+#include <type_traits>
+#include <time.h>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+    /**
+     * @file Record.h
+     * @brief Typed key/value fields for structured log entries.
+     * Fields only capture values (strings by reference), so building a
+     * Record does not allocate. The Record itself goes to the sink, which
+     * renders it (logfmt or JSON), or pack()s it to render later.
+     * @see Logging.h (LOG_FIELDS)
+     */
+namespace Utility
+{
+//==========================================================================
+    //!> Wall clock time, nanoseconds since the epoch
+    struct Stamp
+    {
+        int64_t nanos_;
+
+        static Stamp now()
+        {
+            struct timespec _ts;
+            ::clock_gettime( CLOCK_REALTIME, &_ts );
+            return {_ts.tv_sec * 1000000000LL + _ts.tv_nsec};
+        }
+    };
+
+//==========================================================================
+    struct Field
+    {
+        enum class Type
+        : uint8_t
+        {
+            INT, UINT, REAL, BOOL, TEXT, TIME
+        };
+
+        char const* key_;
+        union
+        {
+            int64_t     int_;
+            uint64_t    uint_;
+            double      real_;
+            bool        bool_;
+            int64_t     time_;
+            struct { char const* ptr_; std::size_t len_; } text_;
+        };
+        Type        type_;
+
+        template<typename I, typename std::enable_if<std::is_integral<I>::value && std::is_signed<I>::value, int>::type = 0>
+        Field(char const* key, I value) : key_(key), int_(value), type_(Type::INT) {}
+        template<typename U, typename std::enable_if<std::is_integral<U>::value && std::is_unsigned<U>::value, int>::type = 0>
+        Field(char const* key, U value) : key_(key), uint_(value), type_(Type::UINT) {}
+
+        Field(char const* key, bool value) : key_(key), bool_(value), type_(Type::BOOL) {}
+        Field(char const* key, double value) : key_(key), real_(value), type_(Type::REAL) {}
+        Field(char const* key, float value) : key_(key), real_(value), type_(Type::REAL) {}
+
+        Field(char const* key, char const* value)
+        : key_(key), text_{value, value ? ::strlen( value ) : 0}, type_(Type::TEXT) {}
+        Field(char const* key, char const* value, std::size_t len)
+        : key_(key), text_{value, len}, type_(Type::TEXT) {}
+        Field(char const* key, std::string const& value)
+        : key_(key), text_{value.data(), value.size()}, type_(Type::TEXT) {}
+        Field(char const* key, std::string&&) = delete; // would dangle
+#if __cplusplus >= 201703L
+        Field(char const* key, std::string_view value)
+        : key_(key), text_{value.data(), value.size()}, type_(Type::TEXT) {}
+#endif
+
+        Field(char const* key, Stamp value) : key_(key), time_(value.nanos_), type_(Type::TIME) {}
+        Field(char const* key, struct timespec const& value)
+        : key_(key), time_(value.tv_sec * 1000000000LL + value.tv_nsec), type_(Type::TIME) {}
+        Field(char const* key, std::chrono::system_clock::time_point value)
+        : key_(key)
+        , time_(std::chrono::duration_cast<std::chrono::nanoseconds>(value.time_since_epoch()).count())
+        , type_(Type::TIME)
+        {}
+    };
+
+    template<typename T>
+    inline Field
+    kv( char const* key, T&& value ) { return Field(key, std::forward<T>(value)); }
+
+//==========================================================================
+    /**
+     * @struct Record
+     * @brief Message plus fields, typically a braced list built by the macros.
+     * A Record refers to its caller's values: a sink that keeps it past the
+     * commit call keeps its pack()ed copy instead.
+     */
+    struct Record
+    {
+        char const*     msg_;
+        Field const*    fields_;
+        std::size_t     count_;
+
+        enum class Format : uint32_t { LOGFMT, JSON };
+
+        Record(char const* msg, Field const* fields, std::size_t count)
+        : msg_(msg), fields_(fields), count_(count) {}
+        //!> The list's array lives as long as the list: pass the Record on in the same expression
+        Record(char const* msg, std::initializer_list<Field> fields)
+        : Record(msg, fields.begin(), fields.size()) {}
+
+        //!> Returns the length that would have been written (as snprintf).
+        std::size_t render( char* buf, std::size_t cap, Format format ) const;
+
+        //!> Appends a self-contained binary copy, strings and keys included.
+        void pack( std::string& out ) const;
+        //!> Renders a pack()ed copy, as render() would the original.
+        static std::size_t render( char const* packed, std::size_t len, char* buf, std::size_t cap, Format format );
+    };
+
+} // namespace Utility
+
+#endif // UTILITY_RECORD_H
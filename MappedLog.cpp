@@ -0,0 +1,173 @@
+/** ======================================================================+
+ + Copyright @2020-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+
+#include "MappedLog.h"
+#include "RotatingFile.h" // archive_name, prune_archives
+
+#include <thread>
+#include <cstring>
+#include <cstdio>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace Utility
+{
+namespace
+{
+    long    pageSize{::sysconf( _SC_PAGE_SIZE )};
+
+    std::size_t page_round( std::size_t size )
+    {
+        return size % pageSize ? size + pageSize - (size % pageSize) : size;
+    }
+}
+
+    /**
+     * One mapped file. Space is claimed with a fetch_add on used_,
+     * which may run past the end: such claims fail and trigger a roll.
+     * The last reference trims the file to what was actually claimed.
+     */
+    struct MappedLog::Segment
+    {
+        int                         fd_;
+        char*                       base_;
+        std::size_t                 size_;
+        std::atomic<std::size_t>    used_{0};
+        std::atomic<uint32_t>       seq_{0};
+
+        ~Segment() noexcept
+        {
+            if ( base_ ) { ::munmap( base_, size_ ); }
+            if ( fd_ >= 0 )
+            {
+                std::size_t _used(used_.load());
+                if ( _used < size_ ) { (void)::ftruncate( fd_, _used ); }
+                ::close( fd_ );
+            }
+        }
+
+        Segment(int fd, char* base, std::size_t size)
+        : fd_(fd)
+        , base_(base)
+        , size_(size)
+        {}
+    };
+
+    MappedLog::~MappedLog() noexcept = default;
+
+    MappedLog::MappedLog(char const* path, std::size_t capacity, unsigned keep)
+    : path_(path)
+    , capacity_(page_round( capacity ))
+    , keep_(keep)
+    , seg_(aside_() ? map_() : SegPtr())
+    {}
+
+    bool
+    MappedLog::write( char const* data, std::size_t len )
+    {
+        if ( len == 0 ) { return true; }
+        std::size_t const   _need(sizeof(Header) + padded( len ));
+        if ( _need > capacity_ ) { return false; } // would never fit
+
+        while ( SegPtr _seg = std::atomic_load( &seg_ ) )
+        {
+            std::size_t _pos(_seg->used_.fetch_add( _need ));
+            if ( _pos + _need > _seg->size_ )
+            {
+                if ( !roll_( _seg ) && std::atomic_load( &seg_ ) == _seg ) { return false; }
+                continue; // retry on the fresh segment
+            }
+
+            Header*     _hdr(reinterpret_cast<Header*>(_seg->base_ + _pos));
+            _hdr->size_  = static_cast<uint32_t>(len);
+            _hdr->check_ = checksum( data, len );
+            _hdr->seq_   = _seg->seq_++;
+            ::memcpy( _seg->base_ + _pos + sizeof(Header), data, len );
+            __atomic_store_n( &_hdr->magic_, uint32_t(MAGIC), __ATOMIC_RELEASE ); // commit
+            return true;
+        }
+        return false;
+    }
+
+    //!> A crashed run's segment is what Reader is for: never truncate one.
+    bool
+    MappedLog::aside_()
+    {
+        struct stat _st;
+        if ( ::stat( path_.c_str(), &_st ) != 0 || _st.st_size == 0 ) { return true; } // nothing to keep
+        if ( ::rename( path_.c_str(), archive_name( path_ ).c_str() ) != 0 )
+        {
+            err_ = errno;
+            return false;
+        }
+        if ( keep_ > 0 ) { prune_archives( path_, keep_ ); }
+        return true;
+    }
+
+    //!> path_ is empty or gone: see aside_() and roll_()
+    MappedLog::SegPtr
+    MappedLog::map_()
+    {
+        int     _fd(::open( path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 ));
+        if ( _fd < 0 )
+        {
+            err_ = errno;
+            return SegPtr();
+        }
+        // reserve the blocks now: no SIGBUS surprises when the disk fills
+        if ( (err_ = ::posix_fallocate( _fd, 0, capacity_ )) != 0 )
+        {
+            ::close( _fd );
+            return SegPtr();
+        }
+        void*   _base(::mmap( nullptr, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0 ));
+        if ( _base == MAP_FAILED )
+        {
+            err_ = errno;
+            ::close( _fd );
+            return SegPtr();
+        }
+        return std::make_shared<Segment>(_fd, static_cast<char*>(_base), capacity_);
+    }
+
+    //!> Writers that lose the race wait (briefly, and rarely) for the winner.
+    bool
+    MappedLog::roll_( SegPtr const& seg )
+    {
+        bool    _idle(false);
+        if ( !rolling_.compare_exchange_strong( _idle, true ) )
+        {
+            while ( rolling_.load() ) { std::this_thread::yield(); }
+            return std::atomic_load( &seg_ ) != seg;
+        }
+
+        bool    _ok(false);
+        if ( std::atomic_load( &seg_ ) == seg )
+        {
+            std::string _archive(archive_name( path_ ));
+            if ( ::rename( path_.c_str(), _archive.c_str() ) == 0 )
+            {
+                if ( SegPtr _next = map_() )
+                {
+                    std::atomic_store( &seg_, _next );
+                    _ok = true;
+                }
+                else { ::rename( _archive.c_str(), path_.c_str() ); }
+            }
+            else { err_ = errno; }
+        }
+        else { _ok = true; }
+        rolling_.store( false );
+        if ( _ok && keep_ > 0 ) { prune_archives( path_, keep_ ); } // outside the roll: writers carry on
+        return _ok;
+    }
+
+} // namespace Utility
@@ -0,0 +1,152 @@
+/** ======================================================================+
+ + Copyright @2020-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#pragma once
+
+#ifndef UTILITY_MAPPEDLOG_H
+#define UTILITY_MAPPEDLOG_H
+
+#include "StrFile.h"
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+namespace Utility
+{
+    /**
+     * @class MappedLog
+     * @brief Append-only record log in a pre-allocated, shared file mapping.
+     * Records go straight into the page cache, so they survive a crash
+     * of the process. Each record is preceded by a header whose size is
+     * written at reservation and whose magic word is stored last, so a
+     * record is either complete, or skippable as torn.
+     * Layout: [Header][payload, padded to 8 bytes]... then zeros.
+     * A full segment is renamed aside (timestamp suffix) and replaced,
+     * as is one left behind by an earlier run, which is there to be
+     * recovered. Only the newest keep of those are retained (0: all).
+     */
+    class MappedLog
+    {
+    public:
+        struct Header
+        {
+            uint32_t    magic_; // committed when == MAGIC
+            uint32_t    size_;  // payload bytes
+            uint32_t    check_; // FNV-1a of payload
+            uint32_t    seq_;   // per segment
+        };
+        enum : uint32_t { MAGIC = 0x474f4c4d }; // "MLOG"
+
+        ~MappedLog() noexcept;
+        MappedLog(char const* path, std::size_t capacity, unsigned keep = 0);
+
+        explicit operator bool() const { return err_.load() == 0; }
+        int error() const { return err_.load(); }
+
+        bool write( char const* data, std::size_t len );
+
+        /**
+         * @class Reader
+         * @brief Walks the committed records of a segment, e.g. after a crash.
+         */
+        class Reader
+        {
+        public:
+            ~Reader() noexcept = default;
+            explicit Reader(char const* path) : file_(path) {}
+
+            explicit operator bool() const { return bool(file_); }
+            int error() const { return file_.error(); }
+
+            //!> Visitor: void(uint32_t seq, char const* data, std::size_t size)
+            //!> Returns the offset just past the last valid record.
+            template<typename Visitor>
+            std::size_t for_each( Visitor&& visitor ) const;
+
+            std::size_t tail() const { return for_each( []( uint32_t, char const*, std::size_t ) {} ); }
+            std::size_t size() const { return file_.size(); }
+
+        private:
+            StrFile     file_;
+        };
+
+        static uint32_t checksum( char const* data, std::size_t len );
+        static std::size_t padded( std::size_t len ) { return (len + 7) & ~std::size_t(7); }
+
+    private:
+        struct Segment;
+        using SegPtr = std::shared_ptr<Segment>;
+
+        std::string         path_;
+        std::size_t         capacity_;
+        unsigned            keep_;
+        std::atomic<int>    err_{0};   // set by writers and by rolls
+        SegPtr              seg_; // only via std::atomic_load/atomic_store
+        std::atomic<bool>   rolling_{false};
+
+        bool aside_();  // of a segment from an earlier run
+        SegPtr map_();
+        bool roll_( SegPtr const& seg );
+
+        MappedLog(MappedLog const&) = delete;
+        MappedLog& operator=( MappedLog const& ) = delete;
+    };
+
+    inline uint32_t
+    MappedLog::checksum( char const* data, std::size_t len )
+    {
+        uint32_t    _hash(2166136261u);
+        while ( len-- > 0 )
+        {
+            _hash ^= static_cast<unsigned char>(*data++);
+            _hash *= 16777619u;
+        }
+        return _hash;
+    }
+
+    /**
+     * Torn records (writer died mid-record) are skipped. A writer that
+     * died before it stored the size leaves a zeroed slot of unknown
+     * length: the walk steps over it, 8 bytes at a time, to the next
+     * committed header (the checksum rules out look-alikes in payloads).
+     */
+    template<typename Visitor>
+    inline std::size_t
+    MappedLog::Reader::for_each( Visitor&& visitor ) const
+    {
+        char const* _base(file_.get());
+        std::size_t _end(file_.size());
+        std::size_t _pos(0);
+        std::size_t _tail(0);
+        bool        _synced(true); // _pos is known to be at a header
+        while ( _pos + sizeof(Header) <= _end )
+        {
+            Header const*   _hdr(reinterpret_cast<Header const*>(_base + _pos));
+            char const*     _data(_base + _pos + sizeof(Header));
+            std::size_t     _next(_pos + sizeof(Header) + padded( _hdr->size_ ));
+            bool            _sized(_hdr->size_ > 0 && _next <= _end);
+
+            if ( _sized && _hdr->magic_ == MAGIC && checksum( _data, _hdr->size_ ) == _hdr->check_ )
+            {
+                visitor( _hdr->seq_, _data, std::size_t(_hdr->size_) );
+                _tail   = _next;
+                _pos    = _next;
+                _synced = true;
+            }
+            else if ( _sized && _synced && _hdr->magic_ != MAGIC ) { _pos = _next; } // torn after its size was stored
+            else
+            {   // no size (or not a header at all): look for the next committed one
+                _pos   += 8;
+                _synced = false;
+            }
+        }
+        return _tail;
+    }
+
+} // namespace Utility
+
+#endif // UTILITY_MAPPEDLOG_H
@@ -0,0 +1,219 @@
+/** ======================================================================+
+ + Copyright @2020-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+
+#include "RotatingFile.h"
+#include "TimeFns.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+
+namespace Utility
+{
+    /**
+     * One generation of the file. Whoever drops the last reference
+     * to a rotated segment (writer or owner) queues it for archiving.
+     */
+    struct RotatingFile::Segment
+    {
+        int                         fd_;
+        std::time_t                 expires_;
+        std::atomic<std::size_t>    bytes_;
+        Jobs*                       jobs_;
+        std::string                 archive_; // set on rotation
+
+        ~Segment() noexcept
+        {
+            if ( fd_ >= 0 ) { ::close( fd_ ); }
+            if ( !archive_.empty() ) { jobs_->put( std::move(archive_) ); }
+        }
+
+        Segment(int fd, std::size_t bytes, long secs, Jobs* jobs)
+        : fd_(fd)
+        , expires_(secs > 0 ? std::time( nullptr ) + secs : 0)
+        , bytes_(bytes)
+        , jobs_(jobs)
+        {}
+    };
+
+namespace
+{
+    bool gzip_file( std::string const& file )
+    {
+        int     _fd(::open( file.c_str(), O_RDONLY ));
+        if ( _fd < 0 ) { return false; }
+
+        gzFile  _gz(::gzopen( (file + ".gz").c_str(), "wb" ));
+        if ( !_gz )
+        {
+            ::close( _fd );
+            return false;
+        }
+
+        char    _buf[65536];
+        ssize_t _nr;
+        bool    _ok(true);
+        while ( _ok && (_nr = ::read( _fd, _buf, sizeof(_buf) )) > 0 )
+        {
+            _ok = ::gzwrite( _gz, _buf, static_cast<unsigned>(_nr) ) == _nr;
+        }
+        ::close( _fd );
+        _ok = (::gzclose( _gz ) == Z_OK) && _ok && _nr == 0;
+        if ( _ok ) { ::unlink( file.c_str() ); }
+        else { ::unlink( (file + ".gz").c_str() ); }
+        return _ok;
+    }
+}
+
+    std::string
+    archive_name( std::string const& path )
+    {
+        LocalTime   _now;
+        return path + _now.format( ".%Y%m%d-%H%M%S" )
+                    + CharBuffer<16>(".%06ld", (_now.ts_.tv_nsec / 1000) % 1000000).get(); // the modulus tells the compiler it fits
+    }
+
+    void
+    prune_archives( std::string const& path, unsigned keep )
+    {
+        auto        _pos(path.rfind( '/' ));
+        std::string _dir(_pos == std::string::npos ? "." : path.substr( 0, _pos + 1 ));
+        std::string _base((_pos == std::string::npos ? path : path.substr( _pos + 1 )) + ".");
+
+        DIR*    _dp(::opendir( _dir.c_str() ));
+        if ( !_dp ) { return; }
+
+        std::vector<std::string>    _olds;
+        while ( auto _ent = ::readdir( _dp ) )
+        {
+            if ( ::strncmp( _ent->d_name, _base.c_str(), _base.size() ) == 0 )
+            {
+                _olds.emplace_back( _ent->d_name );
+            }
+        }
+        ::closedir( _dp );
+
+        if ( _olds.size() <= keep ) { return; }
+        std::sort( _olds.begin(), _olds.end() );
+        _olds.resize( _olds.size() - keep ); // oldest first
+        for ( auto& _old : _olds )
+        {
+            ::unlink( (_pos == std::string::npos ? _old : _dir + _old).c_str() );
+        }
+    }
+
+    RotatingFile::~RotatingFile() noexcept
+    {
+        std::atomic_store( &seg_, SegPtr() );
+        jobs_.stop();
+        worker_.join();
+        // finish whatever the worker did not get to
+        jobs_.drain( [this]( std::string& file ) { archive_( file ); } );
+    }
+
+    RotatingFile::RotatingFile(char const* path, Rotation const& rotation, bool append)
+    : path_(path)
+    , rotation_(rotation)
+    , seg_(open_( append ))
+    , worker_([this]() -> void
+    {   // archiving is strictly background work
+        ::setpriority( PRIO_PROCESS, ::syscall( SYS_gettid ), 19 );
+        jobs_.pump( [this]( std::string& file ) { archive_( file ); } );
+    })
+    {}
+
+    bool
+    RotatingFile::write( char const* data, std::size_t len )
+    {
+        SegPtr  _seg(std::atomic_load( &seg_ ));
+        if ( !_seg ) { return false; }
+
+        while ( len > 0 )
+        {
+            auto    _nw(::write( _seg->fd_, data, len ));
+            if ( _nw < 0 )
+            {
+                if ( errno == EINTR ) { continue; }
+                err_ = errno;
+                return false;
+            }
+            data += _nw;
+            len  -= _nw;
+            _seg->bytes_ += _nw;
+        }
+
+        if ( (rotation_.maxBytes_ > 0 && _seg->bytes_.load() >= rotation_.maxBytes_)
+          || (_seg->expires_ > 0 && std::time( nullptr ) >= _seg->expires_) )
+        {
+            rotate_( _seg );
+        }
+        return true;
+    }
+
+    bool
+    RotatingFile::rotate()
+    {
+        return rotate_( std::atomic_load( &seg_ ) );
+    }
+
+    RotatingFile::SegPtr
+    RotatingFile::open_( bool append )
+    {
+        int     _fd(::open( path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (append ? 0 : O_TRUNC), 0644 ));
+        if ( _fd < 0 )
+        {
+            err_ = errno;
+            return SegPtr();
+        }
+        err_ = 0;
+        off_t   _size(append ? ::lseek( _fd, 0, SEEK_END ) : 0);
+        return std::make_shared<Segment>(_fd, _size < 0 ? 0 : _size, rotation_.maxSecs_, &jobs_);
+    }
+
+    //!> Losers of the race simply carry on with the segment they have.
+    bool
+    RotatingFile::rotate_( SegPtr const& seg )
+    {
+        if ( !seg || rotating_.test_and_set() ) { return false; }
+
+        bool    _ok(false);
+        if ( std::atomic_load( &seg_ ) == seg ) // not already done
+        {
+            std::string _archive(archive_name( path_ ));
+            if ( ::rename( path_.c_str(), _archive.c_str() ) == 0 )
+            {
+                SegPtr  _next(open_( false ));
+                if ( _next )
+                {
+                    seg->archive_ = std::move(_archive);
+                    std::atomic_store( &seg_, _next );
+                    _ok = true;
+                }
+                else { ::rename( _archive.c_str(), path_.c_str() ); } // keep going as we were
+            }
+            else { err_ = errno; }
+        }
+        rotating_.clear();
+        return _ok;
+    }
+
+    void
+    RotatingFile::archive_( std::string const& file )
+    {
+        if ( rotation_.compress_ ) { gzip_file( file ); }
+        if ( rotation_.keep_ > 0 ) { prune_archives( path_, rotation_.keep_ ); }
+    }
+
+} // namespace Utility
@@ -0,0 +1,89 @@
+/** ======================================================================+
+ + Copyright @2020-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#pragma once
+
+#ifndef UTILITY_ROTATINGFILE_H
+#define UTILITY_ROTATINGFILE_H
+
+#include "BasicQueue.h"
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <ctime>
+
+namespace Utility
+{
+    /**
+     * @struct Rotation
+     * @brief Rotation policy: zero values disable the respective limit.
+     */
+    struct Rotation
+    {
+        std::size_t maxBytes_{0};    // rotate when segment reaches this size
+        long        maxSecs_{0};     // rotate when segment is this old
+        unsigned    keep_{0};        // rotated segments retained (0: all)
+        bool        compress_{true}; // gzip rotated segments
+
+        Rotation& bytes( std::size_t max ) { maxBytes_ = max; return *this; }
+        Rotation& secs( long max ) { maxSecs_ = max; return *this; }
+        Rotation& keep( unsigned count ) { keep_ = count; return *this; }
+        Rotation& compress( bool flag ) { compress_ = flag; return *this; }
+    };
+
+    //!> path.YYYYmmdd-HHMMSS.uuuuuu: the name a segment is rotated to; these sort in time order
+    std::string archive_name( std::string const& path );
+
+    //!> Removes all but the newest keep archives of path (compressed or not)
+    void prune_archives( std::string const& path, unsigned keep );
+
+    /**
+     * @class RotatingFile
+     * @brief Append-only file, rotated by size and/or age.
+     * Writers never wait on rotation: the current segment is swapped
+     * atomically, and writers still holding the old one finish into the
+     * renamed file. When the last writer lets go, the rotated segment is
+     * handed to a low priority thread for compression and pruning.
+     */
+    class RotatingFile
+    {
+    public:
+        ~RotatingFile() noexcept;
+        RotatingFile(char const* path, Rotation const& rotation, bool append = true);
+
+        explicit operator bool() const { return err_.load() == 0; }
+        int error() const { return err_.load(); }
+        char const* path() const { return path_.c_str(); }
+
+        bool write( char const* data, std::size_t len );
+        bool rotate(); // unconditionally, unless another rotation is under way
+
+    private:
+        struct Segment;
+        using SegPtr = std::shared_ptr<Segment>;
+        using Jobs   = BasicQueue<std::string>;
+        using Worker = std::thread;
+
+        std::string         path_;
+        Rotation            rotation_;
+        Jobs                jobs_;     // rotated segments to be archived
+        std::atomic<int>    err_{0};   // set by writers and by rotation
+        SegPtr              seg_;      // only via std::atomic_load/atomic_store
+        std::atomic_flag    rotating_ = ATOMIC_FLAG_INIT;
+        Worker              worker_;   // archiver
+
+        SegPtr open_( bool append );
+        bool rotate_( SegPtr const& seg );
+        void archive_( std::string const& file );
+
+        RotatingFile(RotatingFile const&) = delete;
+        RotatingFile& operator=( RotatingFile const& ) = delete;
+    };
+
+} // namespace Utility
+
+#endif // UTILITY_ROTATINGFILE_H
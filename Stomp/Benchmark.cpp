@@ -0,0 +1,227 @@
+/** ======================================================================+
+ + Copyright @2023-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#include "StompAgent.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include <unistd.h>
+
+    /**
+     * End-to-end publish/subscribe throughput and latency, through a
+     * broker: the in-tree stand-in (./Broker) or a real one, as per
+     * AMQBROKER_URL. Each publisher and subscriber has a connection of
+     * its own. Bodies carry their send time (as text: a SEND has no
+     * content-length, so no NULs), so latencies are one way, publish()
+     * to callback, on one host.
+     * Build with: make OPT=-O2
+     */
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        bool                queue_{false};
+        size_t              count_{20000}; // per run, over all publishers
+        std::vector<size_t> sizes_{64, 1024, 16384};
+        std::vector<size_t> pubs_{1, 4};
+        std::vector<size_t> subs_{1, 4};
+        long                wait_{30};     // seconds, for the last message
+    };
+
+    std::vector<size_t>
+    parse_list( char const* arg )
+    {
+        std::vector<size_t> _list;
+        std::istringstream  _iss(arg);
+        std::string         _item;
+        while ( std::getline( _iss, _item, ',' ) )
+        {
+            if ( size_t _value = std::strtoul( _item.c_str(), nullptr, 10 ) ) { _list.push_back( _value ); }
+        }
+        return _list;
+    }
+
+    enum : size_t { STAMP = 20 }; // digits
+
+    int64_t
+    now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    //!> What the subscribers have seen, so far.
+    struct Tally
+    {
+        std::mutex              mx_;
+        std::condition_variable done_;
+        size_t                  expect_;
+        size_t                  got_{0};
+        int64_t                 last_{0};  // ns, of the last arrival
+
+        bool wait( long seconds )
+        {
+            std::unique_lock<std::mutex>    _lock(mx_);
+            return done_.wait_for( _lock, std::chrono::seconds(seconds), [this]() { return got_ >= expect_; } );
+        }
+    };
+
+    class Subscriber
+    {
+    public:
+        ~Subscriber() { agent_.unsubscribe( source_ ); }
+
+        Subscriber(Stomp::EndPoint const& source, Tally& tally, size_t expect)
+        : agent_(true)
+        , source_(source)
+        , tally_(tally)
+        {
+            lat_.reserve( expect );
+            agent_.subscribe_view( source_, [this]( std::string_view body, Stomp::EndPoint const& )
+            {
+                int64_t _now(now_ns());
+                int64_t _sent(0);
+                std::from_chars( body.data(), body.data() + std::min( body.size(), size_t(STAMP) ), _sent );
+
+                std::lock_guard<std::mutex> _guard(tally_.mx_);
+                lat_.push_back( _now - _sent );
+                tally_.last_ = _now;
+                if ( ++tally_.got_ == tally_.expect_ ) { tally_.done_.notify_all(); }
+            });
+            // the broker reads a connection in order: once this is confirmed, so is the SUBSCRIBE
+            agent_.publish_async( Stomp::EndPoint{"bench.sync", false}, std::string() ).get();
+        }
+
+        std::vector<int64_t> const& latencies() const { return lat_; } // with the tally's mx_ held
+
+    private:
+        Stomp::StompAgent       agent_;
+        Stomp::EndPoint         source_;
+        Tally&                  tally_;
+        std::vector<int64_t>    lat_;  // ns
+    };
+
+    void
+    run( Options const& options, size_t size, size_t pubs, size_t subs, int round )
+    {
+        Stomp::EndPoint _dest{"bench." + std::to_string( ::getpid() ) + "." + std::to_string( round ), options.queue_};
+        size_t          _count(options.count_ / pubs * pubs);
+        Tally           _tally;
+        _tally.expect_ = options.queue_ ? _count : _count * subs;
+
+        std::vector<std::unique_ptr<Subscriber>>    _subs;
+        for ( size_t _i(0); _i < subs; ++_i ) { _subs.emplace_back( std::make_unique<Subscriber>(_dest, _tally, _tally.expect_) ); }
+
+        std::vector<std::unique_ptr<Stomp::StompAgent>> _agents;
+        for ( size_t _i(0); _i < pubs; ++_i ) { _agents.emplace_back( std::make_unique<Stomp::StompAgent>(true) ); }
+
+        int64_t                     _start(now_ns());
+        std::vector<std::thread>    _threads;
+        for ( auto& _agent : _agents )
+        {
+            _threads.emplace_back( [&_agent, &_dest, size, _each = _count / pubs]()
+            {
+                std::string _body(std::max( size, size_t(STAMP) ), 'x');
+                for ( size_t _i(0); _i < _each; ++_i )
+                {
+                    char    _stamp[STAMP + 1];
+                    ::snprintf( _stamp, sizeof(_stamp), "%020lld", (long long)now_ns() );
+                    ::memcpy( &_body[0], _stamp, STAMP );
+                    _agent->publish( _dest, _body );
+                }
+            });
+        }
+        for ( auto& _thread : _threads ) { _thread.join(); }
+        int64_t _published(now_ns());
+        bool    _complete(_tally.wait( options.wait_ ));
+
+        std::vector<int64_t>    _lat;
+        size_t                  _got;
+        int64_t                 _last;
+        {
+            std::lock_guard<std::mutex> _guard(_tally.mx_);
+            _got  = _tally.got_;
+            _last = _tally.last_;
+            for ( auto& _sub : _subs ) { _lat.insert( _lat.end(), _sub->latencies().begin(), _sub->latencies().end() ); }
+        }
+        _subs.clear();
+        _agents.clear();
+        std::sort( _lat.begin(), _lat.end() );
+        auto    _pct([&_lat]( double pct ) { return double(_lat[std::min( size_t(pct * _lat.size()), _lat.size() - 1 )]) / 1e3; });
+
+        std::cout << std::setw(6) << (options.queue_ ? "queue" : "topic")
+                  << std::setw(7) << size
+                  << std::setw(5) << pubs
+                  << std::setw(5) << subs
+                  << std::setw(9) << _got;
+        if ( _got == 0 )
+        {
+            std::cout << "  nothing received" << std::endl;
+            return;
+        }
+        std::cout << std::fixed << std::setprecision(0)
+                  << std::setw(11) << double(_count) * 1e9 / (_published - _start)
+                  << std::setw(11) << double(_got) * 1e9 / (_last - _start)
+                  << std::setprecision(1)
+                  << std::setw(10) << _pct( 0.50 )
+                  << std::setw(10) << _pct( 0.99 )
+                  << std::setw(10) << _pct( 0.999 );
+        std::cout << (_complete ? "" : "  (incomplete)") << std::endl;
+    }
+}
+
+    int main( int ac, char* av[] )
+    {
+        Options     _options;
+        int         _opt;
+        while ( (_opt = ::getopt( ac, av, "qn:s:p:c:w:" )) != -1 )
+        {
+            switch ( _opt )
+            {
+            case 'q': _options.queue_ = true; break;
+            case 'n': _options.count_ = std::strtoul( optarg, nullptr, 10 ); break;
+            case 's': _options.sizes_ = parse_list( optarg ); break;
+            case 'p': _options.pubs_  = parse_list( optarg ); break;
+            case 'c': _options.subs_  = parse_list( optarg ); break;
+            case 'w': _options.wait_  = std::strtol( optarg, nullptr, 10 ); break;
+            default:
+                std::cerr << "Usage: " << av[0] << " [-q] [-n <messages>] [-s <sizes>] [-p <publishers>] [-c <subscribers>] [-w <seconds>]\n"
+                          << "  lists are comma separated; the broker is $AMQBROKER_URL (" << DEFAULT_AMQBROKER << ")" << std::endl;
+                return 1;
+            }
+        }
+        if ( _options.count_ == 0 || _options.sizes_.empty() || _options.pubs_.empty() || _options.subs_.empty() )
+        {
+            std::cerr << av[0] << ": nothing to do" << std::endl;
+            return 1;
+        }
+
+        std::cout << "  kind   size pubs subs     recv  pub msg/s  del msg/s    p50 us    p99 us   p999 us" << std::endl;
+        int     _round(0);
+        for ( size_t _size : _options.sizes_ )
+        {
+            for ( size_t _pubs : _options.pubs_ )
+            {
+                for ( size_t _subs : _options.subs_ ) { run( _options, _size, _pubs, _subs, ++_round ); }
+            }
+        }
+        return 0;
+    }
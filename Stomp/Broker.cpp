@@ -0,0 +1,546 @@
+/** ======================================================================+
+ + Copyright @2023-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#include "StompImpl.h"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
+
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+    /**
+     * A loopback stand-in for the broker, so that the client can be
+     * exercised (and benchmarked) without ActiveMQ. One thread, one
+     * epoll set, level-triggered.
+     * Speaks enough STOMP 1.1 for our client: CONNECT/STOMP, SUBSCRIBE
+     * (ack modes, activemq.prefetchSize), UNSUBSCRIBE, SEND, ACK,
+     * DISCONNECT, and a RECEIPT for any frame that asks.
+     * Queues: round robin over the subscribers with room in their
+     * prefetch window; messages wait for a subscriber, and unacknowledged
+     * ones go back when theirs leaves. Topics: to every subscriber, now.
+     * No heart-beats, no transactions, no persistence.
+     */
+
+namespace
+{
+    using Frame = Stomp::FrameView;
+
+    enum : size_t { CHUNK = 64 * 1024, PREFETCH = 1000 }; // ActiveMQ's default for queues
+
+    struct Message
+    {
+        std::string dest_;   // as sent, e.g. /queue/orders
+        std::string extra_;  // other headers, as "key:value\n"...
+        std::string body_;
+        uint64_t    seq_;
+    };
+    using MsgPtr = std::shared_ptr<Message const>;
+
+    struct Client;
+
+    struct Sub
+    {
+        enum class Ack : uint8_t { AUTO, CLIENT, INDIVIDUAL };
+
+        Client*             client_;
+        std::string         id_;
+        std::string         dest_;
+        Ack                 ack_{Ack::AUTO};
+        size_t              prefetch_{PREFETCH};
+        std::deque<MsgPtr>  unacked_; // in delivery order
+
+        bool room() const { return ack_ == Ack::AUTO || unacked_.size() < prefetch_; }
+    };
+
+    struct Dest
+    {
+        bool                isQ_;
+        std::vector<Sub*>   subs_;
+        size_t              next_{0};  // round robin (queues)
+        std::deque<MsgPtr>  waiting_;  // for a subscriber (queues)
+    };
+
+    struct Client
+    {
+        int                 fd_;
+        std::string         in_;
+        size_t              done_{0};  // parsed
+        size_t              have_{0};  // received
+        Stomp::Framer       framer_;
+        std::string         out_;
+        size_t              sent_{0};
+        bool                polling_{false}; // for EPOLLOUT
+        bool                closing_{false}; // once out_ has gone
+        std::map<std::string, std::unique_ptr<Sub>> subs_; // by id
+
+        ~Client() noexcept { ::close( fd_ ); }
+        explicit Client(int fd) : fd_(fd) {}
+    };
+
+    volatile std::sig_atomic_t  stopped(0);
+
+    void on_signal( int ) { stopped = 1; }
+
+    class Broker
+    {
+    public:
+        ~Broker() noexcept;
+        explicit Broker(int port);
+
+        explicit operator bool() const { return listen_ >= 0; }
+        int run();
+
+    private:
+        using Clients = std::unordered_map<int, std::unique_ptr<Client>>;
+        using Dests   = std::unordered_map<std::string, Dest>;
+
+        int             epfd_{-1};
+        int             listen_{-1};
+        Clients         clients_;
+        Dests           dests_;
+        std::vector<int> dirty_;   // clients with output
+        uint64_t        seq_{0};
+        uint64_t        in_{0};    // frames
+        uint64_t        out_{0};
+
+        void accept_();
+        void read_( Client& client );
+        void write_( Client& client );
+        void drop_( Client& client );
+        void handle_( Client& client, Frame const& frame );
+        void subscribe_( Client& client, Frame const& frame );
+        void unsubscribe_( Client& client, std::string const& id );
+        void send_( Frame const& frame );
+        void ack_( Client& client, Frame const& frame );
+        void pump_( Dest& dest );
+        void deliver_( Sub& sub, MsgPtr const& msg );
+        void reply_( Client& client, std::string_view frame );
+        void error_( Client& client, Frame const& frame, char const* msg );
+    };
+
+    std::string
+    to_string( std::string_view view )
+    {
+        return std::string(view.data(), view.size());
+    }
+
+    Broker::~Broker()
+    {
+        clients_.clear();
+        if ( listen_ >= 0 ) { ::close( listen_ ); }
+        if ( epfd_ >= 0 ) { ::close( epfd_ ); }
+    }
+
+    Broker::Broker(int port)
+    : epfd_(::epoll_create1( EPOLL_CLOEXEC ))
+    {
+        int         _fd(::socket( AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 ));
+        int         _one(1);
+        ::sockaddr_in   _addr{};
+        _addr.sin_family      = AF_INET;
+        _addr.sin_port        = htons( (unsigned short)port );
+        _addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+        ::setsockopt( _fd, SOL_SOCKET, SO_REUSEADDR, &_one, sizeof(_one) );
+        if ( epfd_ < 0 || _fd < 0
+          || ::bind( _fd, (::sockaddr*) &_addr, sizeof(_addr) ) < 0
+          || ::listen( _fd, 128 ) < 0 )
+        {
+            std::cerr << "Broker: " << ::strerror( errno ) << std::endl;
+            if ( _fd >= 0 ) { ::close( _fd ); }
+            return;
+        }
+        ::epoll_event   _ev{EPOLLIN, {}};
+        _ev.data.fd = _fd;
+        ::epoll_ctl( epfd_, EPOLL_CTL_ADD, _fd, &_ev );
+        listen_ = _fd;
+    }
+
+    int
+    Broker::run()
+    {
+        ::epoll_event   _events[64];
+        while ( !stopped )
+        {
+            int     _n(::epoll_wait( epfd_, _events, 64, -1 ));
+            if ( _n < 0 )
+            {
+                if ( errno == EINTR ) { continue; }
+                std::cerr << "epoll_wait: " << ::strerror( errno ) << std::endl;
+                return 1;
+            }
+            for ( int _i(0); _i < _n; ++_i )
+            {
+                int     _fd(_events[_i].data.fd);
+                if ( _fd == listen_ ) { accept_(); continue; }
+
+                auto    _itr(clients_.find( _fd ));
+                if ( _itr == clients_.end() ) { continue; } // dropped in this batch
+                Client& _client(*_itr->second);
+                if ( _events[_i].events & EPOLLOUT )
+                {
+                    write_( _client );
+                    if ( !clients_.count( _fd ) ) { continue; }
+                }
+                if ( _events[_i].events & (EPOLLIN | EPOLLHUP | EPOLLERR) ) { read_( _client ); }
+            }
+            // replies and deliveries, a batch at a time
+            std::sort( dirty_.begin(), dirty_.end() );
+            dirty_.erase( std::unique( dirty_.begin(), dirty_.end() ), dirty_.end() );
+            std::vector<int>    _dirty;
+            _dirty.swap( dirty_ );
+            for ( int _fd : _dirty )
+            {
+                auto    _itr(clients_.find( _fd ));
+                if ( _itr != clients_.end() ) { write_( *_itr->second ); }
+            }
+        }
+        std::cerr << "Broker: " << in_ << " frames in, " << out_ << " out" << std::endl;
+        return 0;
+    }
+
+    void
+    Broker::accept_()
+    {
+        while ( true )
+        {
+            int     _fd(::accept4( listen_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC ));
+            if ( _fd < 0 ) { return; } // EAGAIN, mostly
+            int     _one(1);
+            ::setsockopt( _fd, IPPROTO_TCP, TCP_NODELAY, &_one, sizeof(_one) );
+            ::epoll_event   _ev{EPOLLIN, {}};
+            _ev.data.fd = _fd;
+            ::epoll_ctl( epfd_, EPOLL_CTL_ADD, _fd, &_ev );
+            clients_.emplace( _fd, std::make_unique<Client>(_fd) );
+        }
+    }
+
+    /**
+     * The client's framer keeps a partial frame's state relative to its
+     * start, so the buffer can grow or be compacted in between reads.
+     */
+    void
+    Broker::read_( Client& client )
+    {
+        if ( client.in_.size() - client.have_ < CHUNK ) { client.in_.resize( client.have_ + CHUNK ); }
+        ssize_t _nr(::recv( client.fd_, &client.in_[client.have_], client.in_.size() - client.have_, 0 ));
+        if ( _nr <= 0 )
+        {
+            if ( _nr < 0 && (errno == EAGAIN || errno == EINTR) ) { return; }
+            drop_( client );
+            return;
+        }
+        client.have_ += _nr;
+
+        Frame   _frame;
+        char*   _base(&client.in_[0]);
+        while ( size_t _used = client.framer_.fill_frame( _base + client.done_, _base + client.have_, _frame ) )
+        {
+            client.done_ += _used;
+            ++in_;
+            handle_( client, _frame );
+            if ( client.closing_ ) { break; }
+        }
+        if ( client.done_ == client.have_ ) { client.done_ = client.have_ = 0; }
+        else
+        if ( client.done_ > client.have_ / 2 )
+        {
+            client.in_.erase( 0, client.done_ );
+            client.have_ -= client.done_;
+            client.done_  = 0;
+        }
+    }
+
+    void
+    Broker::write_( Client& client )
+    {
+        while ( client.sent_ < client.out_.size() )
+        {
+            ssize_t _ns(::send( client.fd_, client.out_.data() + client.sent_, client.out_.size() - client.sent_,
+                                MSG_NOSIGNAL | MSG_DONTWAIT ));
+            if ( _ns < 0 )
+            {
+                if ( errno == EINTR ) { continue; }
+                if ( errno == EAGAIN || errno == EWOULDBLOCK )
+                {
+                    if ( !client.polling_ )
+                    {
+                        ::epoll_event   _ev{EPOLLIN | EPOLLOUT, {}};
+                        _ev.data.fd = client.fd_;
+                        ::epoll_ctl( epfd_, EPOLL_CTL_MOD, client.fd_, &_ev );
+                        client.polling_ = true;
+                    }
+                    return;
+                }
+                drop_( client );
+                return;
+            }
+            client.sent_ += _ns;
+        }
+        client.out_.clear();
+        client.sent_ = 0;
+        if ( client.polling_ )
+        {
+            ::epoll_event   _ev{EPOLLIN, {}};
+            _ev.data.fd = client.fd_;
+            ::epoll_ctl( epfd_, EPOLL_CTL_MOD, client.fd_, &_ev );
+            client.polling_ = false;
+        }
+        if ( client.closing_ ) { drop_( client ); }
+    }
+
+    //!> Unacknowledged queue messages go to the front of the line again.
+    void
+    Broker::drop_( Client& client )
+    {
+        std::vector<std::string>    _ids;
+        for ( auto& _entry : client.subs_ ) { _ids.push_back( _entry.first ); }
+        for ( auto& _id : _ids ) { unsubscribe_( client, _id ); }
+        ::epoll_ctl( epfd_, EPOLL_CTL_DEL, client.fd_, nullptr );
+        clients_.erase( client.fd_ ); // client is gone
+    }
+
+    void
+    Broker::handle_( Client& client, Frame const& frame )
+    {
+        if ( frame.is( "SEND" ) ) { send_( frame ); }
+        else
+        if ( frame.is( "ACK" ) ) { ack_( client, frame ); }
+        else
+        if ( frame.is( "SUBSCRIBE" ) ) { subscribe_( client, frame ); }
+        else
+        if ( frame.is( "UNSUBSCRIBE" ) ) { unsubscribe_( client, to_string( frame.header( "id" ) ) ); }
+        else
+        if ( frame.is( "CONNECT" ) || frame.is( "STOMP" ) )
+        {
+            reply_( client, "CONNECTED\nversion:1.1\nheart-beat:0,0\nserver:Stomp-Broker/1.0\n\n" );
+        }
+        else
+        if ( frame.is( "DISCONNECT" ) )
+        {
+            client.closing_ = true; // when written out
+            dirty_.push_back( client.fd_ );
+        }
+        else
+        if ( frame.is( "NACK" ) || frame.is( "BEGIN" ) || frame.is( "COMMIT" ) || frame.is( "ABORT" ) )
+        {
+            error_( client, frame, "not supported" );
+            return;
+        }
+        else
+        {
+            error_( client, frame, "unknown command" );
+            return;
+        }
+
+        std::string_view    _receipt(frame.header( "receipt" ));
+        if ( !_receipt.empty() )
+        {
+            client.out_.append( "RECEIPT\nreceipt-id:" ).append( _receipt ).append( "\n\n", 3 );
+            dirty_.push_back( client.fd_ );
+            ++out_;
+        }
+    }
+
+    void
+    Broker::subscribe_( Client& client, Frame const& frame )
+    {
+        std::string         _id(to_string( frame.header( "id" ) ));
+        std::string         _name(to_string( frame.header( "destination" ) ));
+        std::string_view    _ack(frame.header( "ack" ));
+        std::string_view    _prefetch(frame.header( "activemq.prefetchSize" ));
+        bool                _isq(_name.compare( 0, 7, "/queue/" ) == 0);
+        if ( _id.empty() || !(_isq || _name.compare( 0, 7, "/topic/" ) == 0) )
+        {
+            error_( client, frame, "bad subscription" );
+            return;
+        }
+        if ( client.subs_.count( _id ) ) { unsubscribe_( client, _id ); }
+
+        auto    _sub(std::make_unique<Sub>());
+        _sub->client_ = &client;
+        _sub->id_     = _id;
+        _sub->dest_   = _name;
+        if ( _ack == "client" ) { _sub->ack_ = Sub::Ack::CLIENT; }
+        else
+        if ( _ack == "client-individual" ) { _sub->ack_ = Sub::Ack::INDIVIDUAL; }
+        std::from_chars( _prefetch.data(), _prefetch.data() + _prefetch.size(), _sub->prefetch_ );
+        _sub->prefetch_ = std::max( _sub->prefetch_, size_t(1) );
+
+        Dest&   _dest(dests_.try_emplace( _name, Dest{_isq} ).first->second);
+        _dest.subs_.push_back( _sub.get() );
+        client.subs_.emplace( _id, std::move(_sub) );
+        pump_( _dest );
+    }
+
+    void
+    Broker::unsubscribe_( Client& client, std::string const& id )
+    {
+        auto    _itr(client.subs_.find( id ));
+        if ( _itr == client.subs_.end() ) { return; }
+        Sub&    _sub(*_itr->second);
+        Dest&   _dest(dests_[_sub.dest_]);
+        _dest.subs_.erase( std::find( _dest.subs_.begin(), _dest.subs_.end(), &_sub ) );
+        if ( _dest.isQ_ )
+        {
+            _dest.waiting_.insert( _dest.waiting_.begin(), _sub.unacked_.begin(), _sub.unacked_.end() );
+        }
+        client.subs_.erase( _itr );
+        pump_( _dest );
+    }
+
+    void
+    Broker::send_( Frame const& frame )
+    {
+        std::string_view    _name(frame.header( "destination" ));
+        bool                _isq(_name.compare( 0, 7, "/queue/" ) == 0);
+        if ( !_isq && _name.compare( 0, 7, "/topic/" ) != 0 ) { return; }
+
+        auto    _msg(std::make_shared<Message>());
+        _msg->dest_.assign( _name.data(), _name.size() );
+        _msg->body_.assign( frame.body_.data(), frame.body_.size() );
+        _msg->seq_ = ++seq_;
+        for ( size_t _i(0); _i < frame.count_; ++_i )
+        {
+            auto&   _hdr(frame.hdrs_[_i]);
+            if ( _hdr.key_ == "destination" || _hdr.key_ == "receipt" || _hdr.key_ == "content-length" ) { continue; }
+            _msg->extra_.append( _hdr.key_ ).append( 1, ':' ).append( _hdr.value_ ).append( 1, '\n' );
+        }
+
+        Dest&   _dest(dests_.try_emplace( _msg->dest_, Dest{_isq} ).first->second);
+        if ( _dest.isQ_ )
+        {
+            _dest.waiting_.emplace_back( std::move(_msg) );
+            pump_( _dest );
+        }
+        else
+        {
+            for ( Sub* _sub : _dest.subs_ ) { deliver_( *_sub, _msg ); }
+        }
+    }
+
+    //!> Cumulative for client mode, just the one for client-individual.
+    void
+    Broker::ack_( Client& client, Frame const& frame )
+    {
+        auto                _itr(client.subs_.find( to_string( frame.header( "subscription" ) ) ));
+        std::string_view    _msgid(frame.header( "message-id" ));
+        auto                _pos(_msgid.rfind( '-' ));
+        uint64_t            _seq(0);
+        if ( _itr == client.subs_.end() || _pos == std::string_view::npos
+          || std::from_chars( _msgid.data() + _pos + 1, _msgid.data() + _msgid.size(), _seq ).ec != std::errc() )
+        {
+            error_( client, frame, "bad acknowledgement" );
+            return;
+        }
+
+        Sub&    _sub(*_itr->second);
+        auto&   _unacked(_sub.unacked_);
+        if ( _sub.ack_ == Sub::Ack::CLIENT )
+        {
+            while ( !_unacked.empty() && _unacked.front()->seq_ <= _seq ) { _unacked.pop_front(); }
+        }
+        else
+        {
+            auto    _msg(std::find_if( _unacked.begin(), _unacked.end(), [_seq]( MsgPtr const& msg ) { return msg->seq_ == _seq; } ));
+            if ( _msg != _unacked.end() ) { _unacked.erase( _msg ); }
+        }
+        pump_( dests_[_sub.dest_] );
+    }
+
+    void
+    Broker::pump_( Dest& dest )
+    {
+        while ( dest.isQ_ && !dest.waiting_.empty() && !dest.subs_.empty() )
+        {
+            size_t  _tried(0);
+            for ( ; _tried < dest.subs_.size(); ++_tried )
+            {
+                Sub&    _sub(*dest.subs_[dest.next_++ % dest.subs_.size()]);
+                if ( _sub.room() )
+                {
+                    deliver_( _sub, dest.waiting_.front() );
+                    dest.waiting_.pop_front();
+                    break;
+                }
+            }
+            if ( _tried == dest.subs_.size() ) { return; } // all windows are full
+        }
+    }
+
+    void
+    Broker::deliver_( Sub& sub, MsgPtr const& msg )
+    {
+        char    _len[24];
+        char    _seq[24];
+        *std::to_chars( _len, _len + sizeof(_len) - 1, msg->body_.size() ).ptr = '\0';
+        *std::to_chars( _seq, _seq + sizeof(_seq) - 1, msg->seq_ ).ptr = '\0';
+
+        std::string&    _out(sub.client_->out_);
+        _out.append( "MESSAGE\ndestination:" ).append( msg->dest_ )
+            .append( "\nsubscription:" ).append( sub.id_ )
+            .append( "\nmessage-id:ID:stand-in-" ).append( _seq )
+            .append( "\ncontent-length:" ).append( _len ).append( 1, '\n' )
+            .append( msg->extra_ ).append( 1, '\n' )
+            .append( msg->body_ ).append( 1, '\0' );
+        if ( sub.ack_ != Sub::Ack::AUTO ) { sub.unacked_.push_back( msg ); }
+        dirty_.push_back( sub.client_->fd_ );
+        ++out_;
+    }
+
+    void
+    Broker::reply_( Client& client, std::string_view frame )
+    {
+        client.out_.append( frame ).append( 1, '\0' );
+        dirty_.push_back( client.fd_ );
+        ++out_;
+    }
+
+    void
+    Broker::error_( Client& client, Frame const& frame, char const* msg )
+    {
+        std::string_view    _receipt(frame.header( "receipt" ));
+        client.out_.append( "ERROR\nmessage:" ).append( msg );
+        if ( !_receipt.empty() ) { client.out_.append( "\nreceipt-id:" ).append( _receipt ); }
+        client.out_.append( "\n\n" ).append( frame.verb_ ).append( 1, '\0' );
+        dirty_.push_back( client.fd_ );
+        ++out_;
+    }
+}
+
+    int main( int ac, char* av[] )
+    {
+        int     _port(ac > 1 ? std::atoi( av[1] ) : 61613);
+        if ( _port <= 0 )
+        {
+            std::cerr << "Usage: " << av[0] << " [<port>]" << std::endl;
+            return 1;
+        }
+
+        std::signal( SIGINT, on_signal );
+        std::signal( SIGTERM, on_signal );
+
+        Broker  _broker(_port);
+        if ( !_broker ) { return 1; }
+        std::cerr << "Broker: listening on 127.0.0.1:" << _port << std::endl;
+        return _broker.run();
+    }
@@ -0,0 +1,146 @@
+/** ======================================================================+
+ + Copyright @2023-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#include "StompImpl.h"
+#include "Scan.h"
+#include "StrFile.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+    /**
+     * Framer throughput, per scanning kernel.
+     * Input is a capture of broker-to-client STOMP traffic (the raw
+     * TCP payload, e.g. tshark -T fields -e tcp.payload | xxd -r -p),
+     * or else synthetic ActiveMQ MESSAGE frames. First, the kernels are
+     * checked against the scalar one around the 16 and 32 byte strides.
+     * Build with: make OPT=-O2
+     */
+
+    std::string synthesize( size_t count )
+    {
+        std::string _out;
+        std::string _body;
+        for ( size_t _i(0); _i < count; ++_i )
+        {
+            _body.assign( 200 + (_i * 7919) % 1800, 'x' );
+            _out += "MESSAGE\n"
+                    "expires:0\n"
+                    "destination:/queue/bench.orders\n"
+                    "subscription:1\n"
+                    "priority:4\n"
+                    "breadcrumbId:ID-bench-host-41235-1700000000000-0-" + std::to_string( _i ) + "\n"
+                    "message-id:ID:bench-host-41235-1700000000000-3:1:1:1:" + std::to_string( _i ) + "\n"
+                    "persistent:true\n"
+                    "timestamp:" + std::to_string( 1700000000000 + _i ) + "\n";
+            if ( _i % 2 ) { _out += "content-length:" + std::to_string( _body.size() ) + "\n"; }
+            _out += "\n" + _body;
+            _out += '\0';
+            _out += '\n'; // as ActiveMQ does
+        }
+        return _out;
+    }
+
+    size_t parse( char const* start, char const* end )
+    {
+        Stomp::Framer       _framer;
+        Stomp::FrameView    _frame;
+        size_t              _count(0);
+        while ( size_t _used = _framer.fill_frame( start, end, _frame ) )
+        {
+            start += _used;
+            ++_count;
+        }
+        return _count;
+    }
+
+    //!> Every length up to 80, from 4 alignments, with no match or one at each place, and a decoy just past the end
+    bool agree( Stomp::Scan::Kernels const& kernels )
+    {
+        Stomp::Scan::Kernels const& _scalar(*Stomp::Scan::lookup( "scalar" ));
+        char                        _buf[96];
+        size_t                      _bad(0);
+        for ( size_t _off(0); _off < 4; ++_off )
+        {
+            for ( size_t _len(0); _len <= 80; ++_len )
+            {
+                char const* _from(_buf + _off);
+                char const* _end(_from + _len);
+                for ( size_t _at(0); _at <= _len; ++_at ) // _len: none inside
+                {
+                    for ( char _c : {':', '\n'} )
+                    {
+                        ::memset( _buf, 'x', sizeof(_buf) );
+                        _buf[_off + _len] = _c; // the decoy
+                        if ( _at < _len ) { _buf[_off + _at] = _c; }
+                        if ( kernels.find_( _from, _end, _c ) != _scalar.find_( _from, _end, _c )
+                          || kernels.find2_( _from, _end, ':', '\n' ) != _scalar.find2_( _from, _end, ':', '\n' ) )
+                        {
+                            if ( _bad++ < 5 ) { std::cerr << kernels.name_ << ": differs at offset " << _off << ", length " << _len << ", match " << _at << "\n"; }
+                        }
+                    }
+                }
+            }
+        }
+        return _bad == 0;
+    }
+
+    int main( int ac, char* av[] )
+    {
+        std::string     _synth;
+        char const*     _data;
+        size_t          _size;
+        int             _rounds(ac > 2 ? std::atoi( av[2] ) : 200);
+
+        Utility::StrFile    _file(ac > 1 ? av[1] : "/dev/null");
+        if ( ac > 1 )
+        {
+            if ( !_file )
+            {
+                std::cerr << "Usage: " << av[0] << " [<capture> [<rounds>]]: " << ::strerror( _file.error() ) << std::endl;
+                return 1;
+            }
+            _data = _file.get();
+            _size = _file.size();
+        }
+        else
+        {
+            _synth = synthesize( 10000 );
+            _data  = _synth.data();
+            _size  = _synth.size();
+        }
+
+        for ( char const* _name : {"sse2", "avx2"} )
+        {
+            Stomp::Scan::Kernels const* _kernels(Stomp::Scan::lookup( _name ));
+            if ( _kernels && !agree( *_kernels ) )
+            {
+                std::cerr << _name << " does not agree with scalar" << std::endl;
+                return 1;
+            }
+        }
+
+        std::cout << _size << " bytes, " << _rounds << " rounds\n";
+        for ( char const* _name : {"scalar", "sse2", "avx2"} )
+        {
+            if ( !Stomp::Scan::use( _name ) ) { continue; }
+
+            size_t  _frames(parse( _data, _data + _size )); // warm up
+            auto    _start(std::chrono::steady_clock::now());
+            for ( int _i(0); _i < _rounds; ++_i ) { _frames = parse( _data, _data + _size ); }
+            std::chrono::duration<double>   _secs(std::chrono::steady_clock::now() - _start);
+
+            std::cout << std::setw(8) << _name << ": "
+                      << _frames << " frames, "
+                      << std::fixed << std::setprecision(2)
+                      << (double(_size) * _rounds / _secs.count() / 1e9) << " GB/s, "
+                      << (double(_frames) * _rounds / _secs.count() / 1e6) << " Mframes/s\n";
+        }
+        return 0;
+    }
@@ -0,0 +1,225 @@
+/** ======================================================================+
+ + Copyright @2023-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+
+#include "Reactor.h"
+#include "StompImpl.h"
+
+#include <stdexcept>
+#include <condition_variable>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+namespace Stomp
+{
+    /**
+     * One epoll thread. Events already returned by epoll_wait outlive
+     * an EPOLL_CTL_DEL, so detach() waits until the batch that was
+     * under way has been handled: batches are numbered as epoll_wait
+     * is entered, and done_ says how far the loop has got.
+     * Events are edge-triggered: frames a Reader already holds when a
+     * session is attached raise none, so attach() queues the session
+     * on drain_ and wakes the loop, which reads it as if readable.
+     */
+    struct Reactor::Loop
+    {
+        enum { BATCH = 64 };
+
+        Reactor&                reactor_;
+        int                     epfd_;
+        int                     wake_;     // eventfd, for shutdown, drains and detach
+        std::atomic<unsigned>   count_{0}; // attached sessions
+        std::atomic<bool>       stopped_{false};
+        std::mutex              mx_;       // for drain_
+        std::vector<Session*>   drain_;    // attached, not yet read
+        std::mutex              bmx_;      // for batch_, done_
+        std::condition_variable passed_;
+        uint64_t                batch_{0}; // epoll_waits entered
+        uint64_t                done_{0};  // batches handled
+        std::thread             thread_;
+
+        ~Loop() noexcept
+        {
+            stopped_ = true;
+            wake();
+            if ( thread_.joinable() ) { thread_.join(); }
+            ::close( wake_ );
+            ::close( epfd_ );
+        }
+
+        Loop(Reactor& reactor)
+        : reactor_(reactor)
+        , epfd_(::epoll_create1( EPOLL_CLOEXEC ))
+        , wake_(::eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK ))
+        {
+            if ( epfd_ < 0 || wake_ < 0 ) { throw std::runtime_error(::strerror( errno )); }
+            ::epoll_event   _ev{EPOLLIN, {nullptr}};
+            ::epoll_ctl( epfd_, EPOLL_CTL_ADD, wake_, &_ev );
+            thread_ = std::thread(&Loop::run, this);
+        }
+
+        void wake()
+        {
+            uint64_t    _one(1);
+            (void)::write( wake_, &_one, sizeof(_one) );
+        }
+
+        void drain( Session* session )
+        {
+            {
+                std::lock_guard<std::mutex> _guard(mx_);
+                drain_.push_back( session );
+            }
+            wake();
+        }
+
+        void forget( Session* session )
+        {
+            std::lock_guard<std::mutex> _guard(mx_);
+            drain_.erase( std::remove( drain_.begin(), drain_.end(), session ), drain_.end() );
+        }
+
+        //!> Returns once the batch under way, if any, is done: no event from before can still be handled.
+        void quiesce()
+        {
+            std::unique_lock<std::mutex>    _lock(bmx_);
+            uint64_t const                  _batch(batch_);
+            wake(); // in case it waits for events
+            passed_.wait( _lock, [&]() { return done_ >= _batch; } );
+        }
+
+        //!> A session whose peer has gone is detached here, as detach() would.
+        void read( Session* session, std::vector<Session*>& closed )
+        {
+            if ( std::find( closed.begin(), closed.end(), session ) != closed.end() ) { return; } // earlier in the batch
+            if ( session->readable_() ) { return; }
+
+            closed.push_back( session );
+            std::lock_guard<std::mutex> _guard(reactor_.mx_);
+            auto    _itr(reactor_.attached_.find( session ));
+            if ( _itr != reactor_.attached_.end() && _itr->second == this ) // unless detach() got there first
+            {
+                reactor_.attached_.erase( _itr );
+                ::epoll_ctl( epfd_, EPOLL_CTL_DEL, session->conn_.fd(), nullptr );
+                --count_;
+            }
+        }
+
+        void run()
+        {
+            ::epoll_event           _events[BATCH];
+            std::vector<Session*>   _drain;
+            std::vector<Session*>   _closed;
+            while ( !stopped_ )
+            {
+                {
+                    std::lock_guard<std::mutex> _guard(bmx_);
+                    ++batch_;
+                }
+                int     _n(::epoll_wait( epfd_, _events, BATCH, -1 ));
+                if ( _n < 0 && errno != EINTR ) { break; }
+
+                for ( int _i(0); _i < _n; ++_i )
+                {
+                    auto    _session(static_cast<Session*>(_events[_i].data.ptr));
+                    if ( _session ) { read( _session, _closed ); continue; }
+
+                    uint64_t    _count;
+                    (void)::read( wake_, &_count, sizeof(_count) );
+                    {
+                        std::lock_guard<std::mutex> _guard(mx_); // detach() removes them under it
+                        _drain.swap( drain_ );
+                    }
+                    for ( auto _pending : _drain ) { read( _pending, _closed ); }
+                    _drain.clear();
+                }
+                _closed.clear();
+
+                std::lock_guard<std::mutex> _guard(bmx_);
+                done_ = batch_;
+                passed_.notify_all();
+            }
+            std::lock_guard<std::mutex> _guard(bmx_);
+            done_ = UINT64_MAX; // nothing more will be handled
+            passed_.notify_all();
+        }
+    };
+
+    Reactor::~Reactor()
+    {
+        loops_.clear(); // joins
+        for ( auto& _queue : queues_ ) { _queue->stop(); }
+        for ( auto& _worker : workers_ ) { _worker.join(); }
+        for ( auto& _queue : queues_ ) { _queue->drain( []( Job& job ) { job(); } ); }
+    }
+
+    Reactor::Reactor(unsigned loops, unsigned workers)
+    {
+        for ( unsigned _i(0); _i < std::max( loops, 1u ); ++_i ) { loops_.emplace_back( std::make_unique<Loop>(*this) ); }
+        for ( unsigned _i(0); _i < workers; ++_i ) { queues_.emplace_back( std::make_unique<Queue>() ); }
+        for ( auto& _queue : queues_ )
+        {
+            workers_.emplace_back( Queue::Runner(*_queue) );
+        }
+    }
+
+    //!> The least loaded loop takes the connection.
+    bool
+    Reactor::attach( Session& session )
+    {
+        Loop*   _loop(loops_.front().get());
+        for ( auto& _ptr : loops_ )
+        {
+            if ( _ptr->count_.load() < _loop->count_.load() ) { _loop = _ptr.get(); }
+        }
+
+        int     _fd(session.conn_.fd());
+        int     _flags(::fcntl( _fd, F_GETFL ));
+        if ( _flags < 0 || ::fcntl( _fd, F_SETFL, _flags | O_NONBLOCK ) < 0 ) { return false; }
+
+        std::lock_guard<std::mutex> _guard(mx_);
+        ::epoll_event   _ev{EPOLLIN | EPOLLRDHUP | EPOLLET, {&session}};
+        if ( ::epoll_ctl( _loop->epfd_, EPOLL_CTL_ADD, _fd, &_ev ) < 0 ) { return false; }
+        attached_[&session] = _loop;
+        ++_loop->count_;
+        _loop->drain( &session );
+        return true;
+    }
+
+    /**
+     * Not attached (any more): its peer may have gone in a batch still
+     * under way, on whichever loop had it. So every loop is waited on.
+     */
+    void
+    Reactor::detach( Session& session )
+    {
+        Loop*   _loop(nullptr);
+        {
+            std::lock_guard<std::mutex> _guard(mx_);
+            auto    _itr(attached_.find( &session ));
+            if ( _itr != attached_.end() )
+            {
+                _loop = _itr->second;
+                attached_.erase( _itr );
+                ::epoll_ctl( _loop->epfd_, EPOLL_CTL_DEL, session.conn_.fd(), nullptr );
+                --_loop->count_;
+            }
+        }
+        if ( _loop ) { _loop->forget( &session ); }
+        for ( auto& _ptr : loops_ )
+        {
+            if ( (_loop && _ptr.get() != _loop) || std::this_thread::get_id() == _ptr->thread_.get_id() ) { continue; }
+            _ptr->quiesce();
+        }
+    }
+
+} // namespace Stomp
@@ -0,0 +1,69 @@
+/** ======================================================================+
+ + Copyright @2023-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#pragma once
+
+#ifndef UTILITY_STOMPREACTOR_H
+#define UTILITY_STOMPREACTOR_H
+
+#include "BasicQueue.h"
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <atomic>
+#include <functional>
+
+namespace Stomp
+{
+    class Session;
+
+    /**
+     * @class Reactor
+     * @brief Event loop(s) for many Sessions.
+     * Each loop thread owns an epoll set of non-blocking connections,
+     * and parses frames as data arrives. Callbacks run on the loop
+     * thread (zero-copy: the body is a view into the read buffer), or,
+     * with workers, on a pool: messages are copied and handed to the
+     * worker picked by destination, which preserves per-destination order.
+     * A Session started with a Reactor has no thread of its own.
+     * Sessions must not be destroyed from within their own callbacks.
+     */
+    class Reactor
+    {
+    public:
+        using Job = std::function<void()>;
+
+        ~Reactor() noexcept;
+        explicit Reactor(unsigned loops = 1, unsigned workers = 0);
+
+        bool attach( Session& session ); // readable events, and frames already read, now go to session
+        void detach( Session& session ); // on return, no callback for session is running on a loop
+
+        bool pooled() const { return !queues_.empty(); }
+        void post( std::size_t key, Job&& job ) { queues_[key % queues_.size()]->put( std::move(job) ); }
+        bool idle( std::size_t key ) const { return queues_[key % queues_.size()]->size() == 0; }
+
+    private:
+        struct Loop;
+        using LoopPtr = std::unique_ptr<Loop>;
+        using Queue   = Utility::BasicQueue<Job>;
+        using QPtr    = std::unique_ptr<Queue>;
+
+        std::vector<LoopPtr>        loops_;
+        std::mutex                  mx_;
+        std::map<Session*, Loop*>   attached_;
+        std::vector<QPtr>           queues_;  // one per worker
+        std::vector<std::thread>    workers_;
+
+        Reactor(Reactor const&) = delete;
+        Reactor& operator=( Reactor const& ) = delete;
+    };
+
+} // namespace Stomp
+
+#endif // UTILITY_STOMPREACTOR_H
@@ -0,0 +1,186 @@
+/** ======================================================================+
+ + Copyright @2023-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+
+#include "Scan.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STOMP_SCAN_X86 1
+#endif
+
+namespace Stomp
+{
+namespace Scan
+{
+namespace
+{
+    Kernels const* resolve();
+
+    //!> Until the first scan: pick the best set, then do as it does.
+    char const*
+    find_first( char const* from, char const* end, char c )
+    {
+        return resolve()->find_( from, end, c );
+    }
+
+    char const*
+    find2_first( char const* from, char const* end, char a, char b )
+    {
+        return resolve()->find2_( from, end, a, b );
+    }
+
+    char const*
+    find_scalar( char const* from, char const* end, char c )
+    {
+        for ( ; from < end; ++from )
+        {
+            if ( *from == c ) { return from; }
+        }
+        return nullptr;
+    }
+
+    char const*
+    find2_scalar( char const* from, char const* end, char a, char b )
+    {
+        for ( ; from < end; ++from )
+        {
+            if ( *from == a || *from == b ) { return from; }
+        }
+        return nullptr;
+    }
+
+#ifdef STOMP_SCAN_X86
+    // 16 bytes at a time; the (short) tail is done by the scalar loop
+
+    __attribute__((target("sse2"))) char const*
+    find_sse2( char const* from, char const* end, char c )
+    {
+        __m128i const   _c(_mm_set1_epi8( c ));
+        for ( ; end - from >= 16; from += 16 )
+        {
+            __m128i _v(_mm_loadu_si128( reinterpret_cast<__m128i const*>(from) ));
+            if ( int _m = _mm_movemask_epi8( _mm_cmpeq_epi8( _v, _c ) ) ) { return from + __builtin_ctz( _m ); }
+        }
+        return find_scalar( from, end, c );
+    }
+
+    __attribute__((target("sse2"))) char const*
+    find2_sse2( char const* from, char const* end, char a, char b )
+    {
+        __m128i const   _a(_mm_set1_epi8( a ));
+        __m128i const   _b(_mm_set1_epi8( b ));
+        for ( ; end - from >= 16; from += 16 )
+        {
+            __m128i _v(_mm_loadu_si128( reinterpret_cast<__m128i const*>(from) ));
+            if ( int _m = _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( _v, _a ), _mm_cmpeq_epi8( _v, _b ) ) ) )
+            {
+                return from + __builtin_ctz( _m );
+            }
+        }
+        return find2_scalar( from, end, a, b );
+    }
+
+    // 32 bytes at a time, then SSE2 for the rest. Header lines are
+    // short: a 16 byte probe first settles most of them cheaply.
+
+    __attribute__((target("avx2"))) char const*
+    find_avx2( char const* from, char const* end, char c )
+    {
+        if ( end - from >= 16 )
+        {
+            __m128i _v(_mm_loadu_si128( reinterpret_cast<__m128i const*>(from) ));
+            if ( int _m = _mm_movemask_epi8( _mm_cmpeq_epi8( _v, _mm_set1_epi8( c ) ) ) ) { return from + __builtin_ctz( _m ); }
+            from += 16;
+        }
+        __m256i const   _c(_mm256_set1_epi8( c ));
+        for ( ; end - from >= 32; from += 32 )
+        {
+            __m256i _v(_mm256_loadu_si256( reinterpret_cast<__m256i const*>(from) ));
+            if ( unsigned _m = _mm256_movemask_epi8( _mm256_cmpeq_epi8( _v, _c ) ) ) { return from + __builtin_ctz( _m ); }
+        }
+        return find_sse2( from, end, c );
+    }
+
+    __attribute__((target("avx2"))) char const*
+    find2_avx2( char const* from, char const* end, char a, char b )
+    {
+        if ( end - from >= 16 )
+        {
+            __m128i _v(_mm_loadu_si128( reinterpret_cast<__m128i const*>(from) ));
+            if ( int _m = _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( _v, _mm_set1_epi8( a ) ), _mm_cmpeq_epi8( _v, _mm_set1_epi8( b ) ) ) ) )
+            {
+                return from + __builtin_ctz( _m );
+            }
+            from += 16;
+        }
+        __m256i const   _a(_mm256_set1_epi8( a ));
+        __m256i const   _b(_mm256_set1_epi8( b ));
+        for ( ; end - from >= 32; from += 32 )
+        {
+            __m256i _v(_mm256_loadu_si256( reinterpret_cast<__m256i const*>(from) ));
+            if ( unsigned _m = _mm256_movemask_epi8( _mm256_or_si256( _mm256_cmpeq_epi8( _v, _a ), _mm256_cmpeq_epi8( _v, _b ) ) ) )
+            {
+                return from + __builtin_ctz( _m );
+            }
+        }
+        return find2_sse2( from, end, a, b );
+    }
+#endif
+
+    Kernels const   Scalar{"scalar", find_scalar, find2_scalar};
+#ifdef STOMP_SCAN_X86
+    Kernels const   SSE2{"sse2", find_sse2, find2_sse2};
+    Kernels const   AVX2{"avx2", find_avx2, find2_avx2};
+#endif
+
+    Kernels const*
+    best()
+    {
+#ifdef STOMP_SCAN_X86
+        __builtin_cpu_init();
+        if ( __builtin_cpu_supports( "avx2" ) ) { return &AVX2; }
+        if ( __builtin_cpu_supports( "sse2" ) ) { return &SSE2; }
+#endif
+        return &Scalar;
+    }
+
+    // constant initialized: good for scans from other static initializers
+    Kernels const   First{"first", find_first, find2_first};
+
+    Kernels const*
+    resolve()
+    {
+        Kernels const*  _first(&First);
+        active.compare_exchange_strong( _first, best() ); // unless use() got there before
+        return active.load();
+    }
+}
+
+    std::atomic<Kernels const*>  active{&First};
+
+    Kernels const*
+    lookup( char const* name )
+    {
+#ifdef STOMP_SCAN_X86
+        __builtin_cpu_init();
+        if ( ::strcmp( name, "avx2" ) == 0 ) { return __builtin_cpu_supports( "avx2" ) ? &AVX2 : nullptr; }
+        if ( ::strcmp( name, "sse2" ) == 0 ) { return __builtin_cpu_supports( "sse2" ) ? &SSE2 : nullptr; }
+#endif
+        return ::strcmp( name, "scalar" ) == 0 ? &Scalar : nullptr;
+    }
+
+    bool
+    use( char const* name )
+    {
+        Kernels const*  _kernels(lookup( name ));
+        if ( _kernels ) { active.store( _kernels ); }
+        return _kernels != nullptr;
+    }
+
+} // namespace Scan
+} // namespace Stomp
@@ -0,0 +1,55 @@
+/** ======================================================================+
+ + Copyright @2023-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#pragma once
+
+#ifndef UTILITY_STOMPSCAN_H
+#define UTILITY_STOMPSCAN_H
+
+#include <atomic>
+
+    /**
+     * @file Scan.h
+     * @brief Byte scanning kernels for the Framer.
+     * Each kernel returns the first match in [from, end), or nullptr.
+     * The best set for the CPU (AVX2, SSE2, or scalar) is chosen once,
+     * on first use; use() switches explicitly (benchmarks, tests).
+     */
+
+namespace Stomp
+{
+namespace Scan
+{
+    struct Kernels
+    {
+        using Find  = char const* (*)( char const* from, char const* end, char c );
+        using Find2 = char const* (*)( char const* from, char const* end, char a, char b );
+
+        char const* name_;
+        Find        find_;  // first c
+        Find2       find2_; // first a or b
+    };
+
+    extern std::atomic<Kernels const*>  active;
+
+    Kernels const* lookup( char const* name ); // "avx2", "sse2", "scalar"; nullptr if not supported
+    bool use( char const* name );
+
+    inline char const*
+    find( char const* from, char const* end, char c )
+    {
+        return active.load( std::memory_order_relaxed )->find_( from, end, c );
+    }
+
+    inline char const*
+    find2( char const* from, char const* end, char a, char b )
+    {
+        return active.load( std::memory_order_relaxed )->find2_( from, end, a, b );
+    }
+
+} // namespace Scan
+} // namespace Stomp
+
+#endif // UTILITY_STOMPSCAN_H
@@ -0,0 +1,217 @@
+/** ======================================================================+
+ + Copyright @2023-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#include "StompImpl.h"
+#include "Reactor.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <chrono>
+#include <stdexcept>
+#include <cstring>
+
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+    /**
+     * Frames split across reads, on a session's own thread and on a
+     * reactor. A stand-in broker drops the first connection once the
+     * client subscribes, and answers the reconnect with CONNECTED and
+     * the first MESSAGE in one write (so it is already buffered when
+     * the session goes back to the reactor); on the client's SEND, it
+     * writes the rest in pieces cut mid-command, mid-header and
+     * mid-body, pausing between them. One body is large enough to
+     * outgrow the read buffer. Prints a verdict per mode.
+     * Usage: Splittest
+     */
+
+namespace
+{
+    char const  topic[] = "split";
+
+    std::string
+    message( size_t n, std::string const& body )
+    {
+        return "MESSAGE\ndestination:/topic/" + std::string(topic)
+             + "\nsubscription:1\nmessage-id:" + std::to_string( n )
+             + "\ncontent-length:" + std::to_string( body.size() )
+             + "\n\n" + body + '\0';
+    }
+
+    std::vector<std::string>
+    bodies()
+    {
+        std::vector<std::string>    _bodies{"first, with the handshake"};
+        for ( size_t _i(1); _i < 8; ++_i ) { _bodies.push_back( "body " + std::to_string( _i ) + std::string(_i * 97, 'a' + _i) ); }
+        _bodies.push_back( std::string(300000, 'z') );
+        _bodies.push_back( "last" );
+        return _bodies;
+    }
+
+    //!> One connection: replies by the command of each frame the client sends.
+    class Server
+    {
+    public:
+        ~Server() noexcept
+        {
+            if ( thread_.joinable() ) { thread_.join(); }
+            ::close( fd_ );
+        }
+
+        Server(std::vector<std::string> const& bodies)
+        : fd_(::socket( PF_INET, SOCK_STREAM, 0 ))
+        , bodies_(bodies)
+        {
+            ::sockaddr_in   _addr{};
+            ::socklen_t     _len(sizeof(_addr));
+            _addr.sin_family      = AF_INET;
+            _addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+            if ( ::bind( fd_, (::sockaddr*)&_addr, sizeof(_addr) ) < 0 || ::listen( fd_, 1 ) < 0
+              || ::getsockname( fd_, (::sockaddr*)&_addr, &_len ) < 0 )
+            {
+                throw std::runtime_error(::strerror( errno ));
+            }
+            port_   = ntohs( _addr.sin_port );
+            thread_ = std::thread(&Server::run_, this);
+        }
+
+        int port() const { return port_; }
+
+    private:
+        int                             fd_;
+        int                             port_{0};
+        std::vector<std::string> const& bodies_;
+        std::thread                     thread_;
+
+        static void write_( int fd, char const* data, size_t len )
+        {
+            while ( len > 0 )
+            {
+                ssize_t _n(::write( fd, data, len ));
+                if ( _n <= 0 ) { return; }
+                data += _n;
+                len  -= size_t(_n);
+            }
+        }
+
+        //!> Each frame in four pieces, the cuts landing in the command, a header and the body.
+        void rest_( int fd )
+        {
+            for ( size_t _i(1); _i < bodies_.size(); ++_i )
+            {
+                std::string _frame(message( _i, bodies_[_i] ));
+                size_t      _cuts[]{0, 3, _frame.find( "message-id" ) + 4, _frame.size() - bodies_[_i].size() / 2 - 1, _frame.size()};
+                for ( size_t _c(0); _c + 1 < sizeof(_cuts) / sizeof(_cuts[0]); ++_c )
+                {
+                    write_( fd, _frame.data() + _cuts[_c], _cuts[_c + 1] - _cuts[_c] );
+                    std::this_thread::sleep_for( std::chrono::milliseconds(5) );
+                }
+            }
+        }
+
+        //!> The first connection is dropped on SUBSCRIBE: the second, the reconnect, does the work.
+        void run_()
+        {
+            for ( int _conn(0); _conn < 2; ++_conn )
+            {
+                int         _fd(::accept( fd_, nullptr, nullptr ));
+                std::string _in;
+                char        _buf[4096];
+                ssize_t     _n;
+                while ( _fd >= 0 && (_n = ::read( _fd, _buf, sizeof(_buf) )) > 0 )
+                {
+                    _in.append( _buf, size_t(_n) );
+                    size_t  _end;
+                    while ( (_end = _in.find( '\0' )) != std::string::npos )
+                    {
+                        std::string _frame(_in, 0, _end);
+                        _frame.erase( 0, _frame.find_first_not_of( '\n' ) ); // heart-beats
+                        _in.erase( 0, _end + 1 );
+                        std::string _command(_frame.substr( 0, _frame.find( '\n' ) ));
+                        if ( _command == "STOMP" || _command == "CONNECT" )
+                        {
+                            std::string _reply(std::string("CONNECTED\nversion:1.1\n\n") + '\0');
+                            if ( _conn > 0 ) { _reply += message( 0, bodies_[0] ); }
+                            write_( _fd, _reply.data(), _reply.size() );
+                        }
+                        else
+                        if ( _command == "SUBSCRIBE" && _conn == 0 ) { _in.clear(); ::shutdown( _fd, SHUT_RDWR ); }
+                        else
+                        if ( _command == "SEND" ) { rest_( _fd ); }
+                        else
+                        if ( _command == "DISCONNECT" ) { _in.clear(); ::shutdown( _fd, SHUT_RDWR ); }
+                    }
+                }
+                if ( _fd >= 0 ) { ::close( _fd ); }
+            }
+        }
+    };
+
+    //!> What the callback has seen, so far.
+    struct Tally
+    {
+        std::mutex                  mx_;
+        std::condition_variable     cv_;
+        std::vector<std::string>    got_;
+
+        void add( std::string_view body )
+        {
+            std::lock_guard<std::mutex> _guard(mx_);
+            got_.emplace_back( body );
+            cv_.notify_all();
+        }
+
+        bool wait( size_t count, long millis )
+        {
+            std::unique_lock<std::mutex> _lock(mx_);
+            return cv_.wait_for( _lock, std::chrono::milliseconds(millis), [&]() { return got_.size() >= count; } );
+        }
+    };
+
+    bool
+    run( char const* mode, Stomp::Reactor* reactor )
+    {
+        std::vector<std::string> const  _bodies(bodies());
+        Server                          _server(_bodies);
+        Tally                           _tally;
+        Stomp::EndPoint const           _topic{topic, false};
+        bool                            _first;
+        {
+            Stomp::Connection   _conn("127.0.0.1", _server.port(), Stomp::Keepalive().reconnect( 10 ));
+            std::unique_ptr<Stomp::Session> _session(reactor ? new Stomp::Session(_conn, *reactor) : new Stomp::Session(_conn));
+            _session->start();
+            _session->subscribe_view( _topic, [&]( std::string_view body, Stomp::EndPoint const& ) { _tally.add( body ); } );
+
+            _first = _tally.wait( 1, 2000 ); // buffered with CONNECTED: no more input is coming
+            _session->publish( "more", _topic );
+            _tally.wait( _bodies.size(), 10000 );
+        }
+
+        bool    _ok(_first && _tally.got_ == _bodies);
+        std::cout << (_ok ? "ok   " : "FAIL ") << mode << ": " << _tally.got_.size() << " of " << _bodies.size() << " messages";
+        if ( !_first ) { std::cout << " (the first, buffered at reattach, was not delivered)"; }
+        std::cout << std::endl;
+        return _ok;
+    }
+}
+
+    int main( void )
+    {
+        bool            _ok(run( "thread", nullptr ));
+        Stomp::Reactor  _reactor;
+        _ok = run( "reactor", &_reactor ) && _ok;
+        Stomp::Reactor  _pooled(1, 2);
+        _ok = run( "reactor+workers", &_pooled ) && _ok;
+        return _ok ? 0 : 1;
+    }
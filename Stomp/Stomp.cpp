@@ -5,19 +5,31 @@
  +========================================================================*/
 
 #include "StompImpl.h"
+#include "Scan.h"
+#include "Reactor.h"
+#include "Scheduler.h"
 
 #include <cstdio>
 #include <cstring>
+#include <charconv>
 #include <functional>
+#include <algorithm>
 //#include <regex>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
+#include <chrono>
+#include <random>
 
 #include <iostream>
 
 #include <unistd.h>
 #include <errno.h>
+#include <strings.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netdb.h>
@@ -26,7 +38,7 @@
 namespace Stomp
 {
     using Guard  = std::lock_guard<std::mutex>;
-    using Locker = std::lock_guard<Utility::WaitQueue>;
+    using Lock   = std::unique_lock<std::mutex>;
 
 namespace
 {
@@ -37,6 +49,24 @@ namespace
         if ( OnError ) { OnError( code, msg ); }
         else { throw std::runtime_error(msg); }
     }
+
+    // the peer, or the way to it, is gone (-1: nothing could be sent)
+    bool lost( int err )
+    {
+        switch ( err )
+        {
+        case -1: case EPIPE: case ECONNRESET: case ECONNABORTED: case ENOTCONN:
+        case ETIMEDOUT: case EHOSTUNREACH: case ENETUNREACH: case ENETDOWN:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    int64_t now_ms()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
 }
 
 // ======================================================================
@@ -93,153 +123,335 @@ namespace
 namespace
 {
     ssize_t
-    fill_( int fd, char* loc, size_t cap )
+    fill_( int fd, char* loc, size_t cap, int flags = 0 )
     {
         while ( true )
         {
             errno = 0;
-            auto    _nr(::recv( fd, loc, cap, 0 ));
+            auto    _nr(::recv( fd, loc, cap, flags ));
 
             if ( _nr < 0 )
             {
                 if ( errno == EINTR ) { continue; }
+                if ( errno == EAGAIN || errno == EWOULDBLOCK ) { return -1; } // non-blocking: drained
+                if ( lost( errno ) ) { return 0; } // as good as closed
                 on_error( ::strerror( errno ), _nr );
             }
             return _nr;
         }
     }
 
-    bool
-    drain_( int fd, char const* buf, size_t len )
+    //!> 0, the errno, or -1 if nothing could be sent. iov is consumed (adjusted) as it goes.
+    int
+    drain_( int fd, ::iovec* iov, size_t count, int flags )
     {
-        do {
-            errno = 0;
-            auto    _ns(::send( fd, buf, len, 0 ));
+        while ( count > 0 )
+        {
+            ::msghdr    _msg{};
+            _msg.msg_iov    = iov;
+            _msg.msg_iovlen = count;
+
+            auto    _ns(::sendmsg( fd, &_msg, flags | MSG_NOSIGNAL ));
             if ( _ns < 0 )
             {
                 if ( errno == EINTR ) { continue; }
-                on_error( ::strerror( errno ), len );
+                if ( errno == EAGAIN || errno == EWOULDBLOCK ) // non-blocking (reactor): wait for room
+                {
+                    ::pollfd    _pfd{fd, POLLOUT, 0};
+                    ::poll( &_pfd, 1, -1 );
+                    continue;
+                }
+                return errno;
             }
-            if ( _ns == 0 ) { return false; }
-            len -= _ns;
-            buf += _ns;
-        } while ( len > 0 );
+            if ( _ns == 0 ) { return -1; }
 
-        return true;
+            size_t  _sent(_ns);
+            while ( count > 0 && _sent >= iov->iov_len )
+            {
+                _sent -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if ( count > 0 ) // part way into this one
+            {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + _sent;
+                iov->iov_len -= _sent;
+            }
+        }
+        return 0;
     }
 }
 
 // ======================================================================
-    struct Frame
+    bool
+    FrameView::destination( std::string_view& name, bool& isQ ) const
     {
-        std::string verb_;
-        std::string hdrs_;
-        std::string body_;
+        std::string_view    _dest(header( "destination" ));
+        if ( _dest.compare( 0, 7, "/queue/" ) == 0 ) { isQ = true; }
+        else
+        if ( _dest.compare( 0, 7, "/topic/" ) == 0 ) { isQ = false; }
+        else { return false; }
+        name = _dest.substr( 7 );
+        return true;
+    }
 
-        ~Frame() noexcept = default;
-        Frame& reset() { return *this = Frame(); }
-    };
+    std::ostream& operator<<( std::ostream& os, FrameView const& frame )
+    {
+        os << frame.verb_ << '\n';
+        for ( size_t _i(0); _i < frame.count_; ++_i )
+        {
+            os << frame.hdrs_[_i].key_ << ':' << frame.hdrs_[_i].value_ << '\n';
+        }
+        return os << '\n' << frame.body_;
+    }
+
+namespace
+{
+    // a line, less any STOMP 1.2 CR
+    std::string_view
+    line_( char const* start, char const* eol )
+    {
+        return std::string_view(start, (eol > start && eol[-1] == '\r') ? eol - start - 1 : eol - start);
+    }
 
-    std::ostream& operator<<( std::ostream& os, Frame const& frame )
+    bool
+    receipt_id( FrameView const& frame, uint64_t& id )
     {
-        return os << frame.verb_ << frame.hdrs_ << frame.body_;
+        std::string_view    _value(frame.header( "receipt-id" ));
+        return !_value.empty()
+            && std::from_chars( _value.data(), _value.data() + _value.size(), id ).ec == std::errc();
     }
 
+    bool
+    is_content_length( std::string_view key )
+    {
+        return key.size() == 14 && ::strncasecmp( key.data(), "content-length", 14 ) == 0;
+    }
+}
+
     /**
      * Recvside: Frames are unmarshalled and dispatched
      */
 
     size_t
-    Framer::fill_frame( char* start, char* end, Frame& frame )
+    Framer::fill_frame( char const* start, char const* end, FrameView& frame )
     {
-        if ( !eoh_ )
+        if ( stage_ == Stage::START )
         {
-            eoh_ = ::strstr( start, "\n\n" ); // end of headers
-            if ( !eoh_ ) { return 0; }
+            // weird hack for ActiveMQ: server responses have trailing NL(s)!
+            while ( start + skip_ < end && (start[skip_] == '\n' || start[skip_] == '\r') ) { ++skip_; }
+            if ( start + skip_ == end ) { return 0; }
+            frame.verb_  = std::string_view();
+            frame.count_ = 0;
+            stage_       = Stage::HEADERS;
         }
+        else { resume_( start, frame ); }
 
-        // eoh_ now defined, search headers
-        if ( !havecl_ )
+        char const* _frame(start + skip_);
+
+        if ( stage_ == Stage::HEADERS ) // verb, then headers up to the blank line
         {
-            eoh_[1] = '\0';
-            char* _cl = ::strcasestr( start, "Content-Length:" );
-            if ( _cl )
+            while ( true )
             {
-                ::sscanf( _cl + 15, "%lu", &len_ );  // strlen( "Content-Length:" );
+                char const* _bol(_frame + scan_);
+                char const* _eol(Scan::find2( _bol, end, ':', '\n' ));
+                if ( !_eol ) { return suspend_( start, frame ); }
+                char const* _colon(nullptr);
+                if ( *_eol == ':' )
+                {
+                    _colon = _eol;
+                    if ( !(_eol = Scan::find( _colon + 1, end, '\n' )) ) { return suspend_( start, frame ); }
+                }
+                scan_ = _eol + 1 - _frame;
+
+                std::string_view    _line(line_( _bol, _eol ));
+                if ( _bol == _frame )
+                {
+                    frame.verb_ = _line;
+                    continue;
+                }
+                if ( _line.empty() ) { break; }
+                if ( !_colon ) { continue; } // not a header
+
+                FrameView::Header   _hdr{_line.substr( 0, _colon - _bol ), _line.substr( _colon + 1 - _bol )};
+                if ( !havecl_ && is_content_length( _hdr.key_ ) )
+                {
+                    havecl_ = std::from_chars( _hdr.value_.data(), _hdr.value_.data() + _hdr.value_.size(), len_ ).ec == std::errc();
+                }
+                if ( frame.count_ < FrameView::MAXHEADERS ) { frame.hdrs_[frame.count_++] = _hdr; }
             }
-            else { len_ = 0; } // no Content-Length header
-            havecl_ = true;
+            body_  = scan_;
+            stage_ = Stage::BODY;
         }
 
-        if ( len_ > 0 )
+        char const* _body(_frame + body_);
+        char const* _nul;
+        if ( havecl_ )
         {
-            if ( eoh_ + 2 + len_ >= end ) { return 0; }
-            frame.body_ = std::string(eoh_ + 2, len_);
+            if ( size_t(end - _body) <= len_ ) { return suspend_( start, frame ); } // need the 0-byte too
+            _nul = _body + len_;
         }
         else
         {
-           char* _ptr(eoh_ + 2);
-           while ( *_ptr ) { ++_ptr; }
-           if ( _ptr == end ) { return 0; } // we haven't found the 0-byte
-           len_ = _ptr - eoh_ - 2;
-           if ( len_ > 0 ) { frame.body_ = std::string(eoh_ + 2, len_); }
+            char const* _from(_frame + scan_);
+            _nul = Scan::find( _from, end, '\0' );
+            if ( !_nul )
+            {
+                scan_ = end - _frame; // not again
+                return suspend_( start, frame );
+            }
         }
+        frame.body_ = std::string_view(_body, _nul - _body);
 
-        // verb
-        char* _eol  = ::strpbrk( start, "\n" );
-        frame.verb_ = std::string(start, _eol - start);
-        // meta data
-        frame.hdrs_ = std::string( _eol + 1, eoh_ - _eol );
+        size_t  _used((_nul - start) + 1);
+        reset();
+        return _used;
+    }
 
-        return (eoh_ - start) + len_ + 3;
+    //!> The frame so far, as offsets: the FrameView, and the bytes, may be different next time.
+    size_t
+    Framer::suspend_( char const* start, FrameView const& frame )
+    {
+        char const* _frame(start + skip_);
+        verb_  = frame.verb_.size();
+        count_ = frame.count_;
+        for ( size_t _i(0); _i < count_; ++_i )
+        {
+            FrameView::Header const&    _hdr(frame.hdrs_[_i]);
+            hdrs_[_i] = Span{uint32_t(_hdr.key_.data() - _frame), uint32_t(_hdr.value_.data() - _frame), uint32_t(_hdr.key_.size()), uint32_t(_hdr.value_.size())};
+        }
+        return 0;
     }
 
-    bool
-    Reader::read_frame( Frame& frame, int fd )
+    void
+    Framer::resume_( char const* start, FrameView& frame ) const
     {
-        do {
-            if ( !parsing_ )
-            {
-                size_t  _cap = BUFFERSIZE - (fillpt_ - buffer_);
-                if ( _cap == 0 ) { on_error( "TOO LARGE", _cap ); }
+        char const* _frame(start + skip_);
+        frame.verb_  = std::string_view(_frame, verb_);
+        frame.count_ = count_;
+        for ( size_t _i(0); _i < count_; ++_i )
+        {
+            Span const& _span(hdrs_[_i]);
+            frame.hdrs_[_i] = FrameView::Header{std::string_view(_frame + _span.key_, _span.klen_), std::string_view(_frame + _span.value_, _span.vlen_)};
+        }
+    }
 
-                auto    _nr(fill_( fd, fillpt_, _cap ));
+    Reader::~Reader()
+    {
+        if ( ring_ ) { ::munmap( ring_, 2 * RINGSIZE ); }
+    }
 
-                if ( _nr == 0 ) { return false; }
+    Reader::Reader()
+    {
+        // reserve twice the span, then map the same pages into both halves
+        void*   _base(::mmap( nullptr, 2 * RINGSIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ));
+        if ( _base == MAP_FAILED ) { on_error( ::strerror( errno ), errno ); return; }
+        ring_ = static_cast<char*>(_base);
+
+        int     _fd(::memfd_create( "stomp-reader", MFD_CLOEXEC ));
+        bool    _ok(_fd >= 0 && ::ftruncate( _fd, RINGSIZE ) == 0
+                 && ::mmap( ring_, RINGSIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, _fd, 0 ) != MAP_FAILED
+                 && ::mmap( ring_ + RINGSIZE, RINGSIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, _fd, 0 ) != MAP_FAILED);
+        int     _err(errno);
+        if ( _fd >= 0 ) { ::close( _fd ); } // the mappings keep the pages
+        if ( !_ok ) { on_error( ::strerror( _err ), _err ); }
+    }
 
-                left_   += _nr;
-                fillpt_ += _nr;
-                *fillpt_ = '\0'; // sentinel for string operations
-                parsing_ = true;
-            }
+    Reader::Read
+    Reader::read_some( FrameView& frame, int fd, bool wait )
+    {
+        // the previous frame has been dispatched: its bytes may go now
+        if ( spilling_ && slen_ - sdone_ <= RINGSIZE )
+        {
+            ::memcpy( at_( tail_ ), spill_.get() + sdone_, slen_ - sdone_ );
+            tail_    += slen_ - sdone_;
+            slen_     = sdone_ = 0;
+            spilling_ = false;
+        }
 
-            // weird hack for ActiveMQ: server responses have trailing NL(s)!
-            while ( left_ > 0 && buffer_[done_] == '\n' ) { ++done_; --left_; }
+        while ( !next_( frame ) )
+        {
+            auto    _nr(load_( fd, wait ? 0 : MSG_DONTWAIT ));
+            if ( _nr == 0 ) { return Read::CLOSED; }
+            if ( _nr < 0 ) { return Read::AGAIN; }
+        }
+        return Read::FRAME;
+    }
 
-            // parsing phase invariant: (fillpt_ - buffer_) == done_ + left_
+    bool
+    Reader::next_( FrameView& frame )
+    {
+        size_t  _used;
+        if ( spilling_ )
+        {
+            if ( (_used = parser_.fill_frame( spill_.get() + sdone_, spill_.get() + slen_, frame )) == 0 ) { return false; }
+            sdone_ += _used;
+        }
+        else
+        {
+            if ( (_used = parser_.fill_frame( at_( head_ ), at_( head_ ) + (tail_ - head_), frame )) == 0 ) { return false; }
+            head_ += _used;
+        }
+        return true;
+    }
 
-            parser_.reset();  // could fine tune this, maybe
-            auto    _used = left_ > 0
-            ? parser_.fill_frame( buffer_ + done_, fillpt_, frame )
-            : 0;
+    ssize_t
+    Reader::load_( int fd, int flags )
+    {
+        size_t  _free(RINGSIZE - (tail_ - head_));
+        if ( !spilling_ && _free == 0 )
+        {
+            // an incomplete frame fills the ring: set it aside (the parser carries on)
+            spill_grow_( 2 * RINGSIZE );
+            ::memcpy( spill_.get(), at_( head_ ), RINGSIZE );
+            slen_     = RINGSIZE;
+            head_     = tail_;
+            spilling_ = true;
+        }
 
-            if ( _used > 0 )
-            {
-                done_ += _used;
-                left_ -= _used;
-                return true;
-            }
-            else
+        ssize_t _nr;
+        if ( spilling_ )
+        {
+            if ( slen_ == scap_ && !spill_grow_( slen_ - sdone_ < scap_ / 2 ? scap_ : 2 * scap_ ) )
             {
-                parsing_ = false;
-                if ( done_ > 0 )
-                {
-                    if ( left_ > 0 ) { ::memmove( buffer_, buffer_ + done_, left_ ); }
-                    done_ = 0;
-                }
-                fillpt_ = buffer_ + left_;
+                reset(); // the stream cannot go on past this frame: as if closed
+                return 0;
             }
-        } while ( true );
+            if ( (_nr = fill_( fd, spill_.get() + slen_, scap_ - slen_, flags )) > 0 ) { slen_ += _nr; }
+        }
+        else
+        if ( (_nr = fill_( fd, at_( tail_ ), _free, flags )) > 0 ) { tail_ += _nr; }
+
+        if ( _nr > 0 ) { bytes_.fetch_add( _nr, std::memory_order_relaxed ); }
+        return _nr;
+    }
+
+    //!> Whatever was left of the old connection's stream is dropped.
+    void
+    Reader::reset()
+    {
+        head_     = tail_ = 0;
+        slen_     = sdone_ = 0;
+        spilling_ = false;
+        parser_.reset();
+    }
+
+    //!> Also drops what has been consumed (the frame under way moves to the front).
+    bool
+    Reader::spill_grow_( size_t need )
+    {
+        if ( need > MAXFRAME )
+        {
+            on_error( "TOO LARGE", need ); // throws, unless OnError is set
+            return false;
+        }
+        Spill   _spill(new char[need]);
+        if ( slen_ > sdone_ ) { ::memcpy( _spill.get(), spill_.get() + sdone_, slen_ - sdone_ ); }
+        slen_ -= sdone_;
+        sdone_ = 0;
+        spill_ = std::move(_spill);
+        scap_  = need;
+        return true;
     }
 
 // ======================================================================
@@ -247,16 +459,130 @@ namespace
      * Sendside: we construct Frames implicitly on the fly.
      */
 
+    /**
+     * A connection's heart-beat timer, shared with the scheduler, which
+     * may still hold it after the connection has gone: beat_ is then empty.
+     */
+    struct Pulse
+    {
+        std::mutex              mx_;
+        std::function<bool()>   beat_; // false: no more
+        long                    tick_{0};
+    };
+
+namespace
+{
+    struct Beats
+    {
+        using item_type = std::shared_ptr<Pulse>;
+
+        void operator()( item_type& pulse );
+    };
+
+    //!> One timer thread for all connections.
+    Utility::Scheduler<Beats>&
+    beats()
+    {
+        static Utility::Scheduler<Beats>    _beats{Beats()};
+        return _beats;
+    }
+
+    void
+    Beats::operator()( item_type& pulse )
+    {
+        std::lock_guard<std::mutex> _guard(pulse->mx_);
+        if ( pulse->beat_ && pulse->beat_() ) { beats().schedule( pulse, pulse->tick_ ); }
+    }
+}
+
+    /**
+     * A frame waiting to go out. It lives on its publisher's stack:
+     * the publisher does not return until it has been written.
+     */
+    struct Connection::Pending
+    {
+        ::iovec     iov_[3];
+        int         count_;
+        int         err_{0};
+        bool        done_{false};
+    };
+
+    /**
+     * Flat combining: frames are queued, and whoever finds no flush in
+     * progress writes everything queued so far, in as few sendmsg()s as
+     * IOV_MAX allows (MSG_MORE between them). Publishers arriving
+     * meanwhile queue up for the next round, run by one of them.
+     */
+    int
+    Connection::write_( ::iovec const* iov, int count, bool force )
+    {
+        Pending _mine;
+        std::copy( iov, iov + count, _mine.iov_ );
+        _mine.count_ = count;
+
+        Lock    _lock(pmx_);
+        if ( !open_ && !force ) { return ENOTCONN; } // not before the STOMP frame
+        pending_.push_back( &_mine );
+        while ( !_mine.done_ )
+        {
+            if ( flushing_ ) { flushed_.wait( _lock ); continue; }
+
+            flushing_ = true;
+            batch_.swap( pending_ );
+            _lock.unlock();
+            int     _err(flush_( batch_ ));
+            if ( _err == 0 ) { written_.store( now_ms(), std::memory_order_relaxed ); }
+            _lock.lock();
+            for ( auto _pending : batch_ )
+            {
+                _pending->err_  = _err;
+                _pending->done_ = true;
+            }
+            batch_.clear();
+            flushing_ = false;
+            flushed_.notify_all();
+        }
+        return _mine.err_;
+    }
+
+    //!> When we reconnect, a lost connection is no surprise.
+    bool
+    Connection::transmit_( ::iovec const* iov, int count )
+    {
+        int     _err(write_( iov, count ));
+        if ( _err > 0 && !(keep_.reconnect_ && lost( _err )) ) { on_error( ::strerror( _err ), _err ); }
+        return _err == 0;
+    }
+
     bool
     Connection::transmit_( std::string const& data )
     {
-        char const* _ptr(data.data());
-        size_t      _left(data.size() + 1); // yes!! The trailing NULL
-        Locker      _locker(writers_);
+        ::iovec     _iov{const_cast<char*>(data.data()), data.size() + 1}; // yes!! The trailing NULL
+        return transmit_( &_iov, 1 );
+    }
 
-        return drain_( sockp_->fd_, _ptr, _left );
+    //!> Only the flushing thread gets here, so iovs_ is its own.
+    int
+    Connection::flush_( std::vector<Pending*> const& batch )
+    {
+        iovs_.clear();
+        for ( auto _pending : batch )
+        {
+            iovs_.insert( iovs_.end(), _pending->iov_, _pending->iov_ + _pending->count_ );
+        }
+
+        size_t  _left(iovs_.size());
+        for ( ::iovec* _iov(iovs_.data()); _left > 0; )
+        {
+            size_t  _count(std::min<size_t>( _left, IOV_MAX ));
+            if ( int _err = drain_( sockp_->fd_, _iov, _count, _left > _count ? MSG_MORE : 0 ) ) { return _err; }
+            _iov  += _count;
+            _left -= _count;
+        }
+        return 0;
     }
 
+    //!> Ahead of anything else on a new connection.
     bool
     Connection::stomp_()
     {
@@ -264,48 +590,125 @@ namespace
         _oss << "STOMP\naccept-version:1.0,1.1"
              << "\nhost:"
              << host_
+             << "\nheart-beat:"
+             << std::max( keep_.beat_, 0L ) << ',' << std::max( keep_.expect_, 0L )
              << "\n\n"
              << "\0";
-        return transmit_( _oss.str() );
+        std::string _frame(_oss.str());
+        ::iovec     _iov{const_cast<char*>(_frame.data()), _frame.size() + 1};
+        int         _err(write_( &_iov, 1, true ));
+        if ( _err > 0 && !keep_.reconnect_ ) { on_error( ::strerror( _err ), _err ); }
+        return _err == 0;
     }
 
 namespace
 {
     std::string   disconnect = "DISCONNECT\n\n\0";
+    char          terminator[] = "";
 }
 
+    //!> Also ends any reconnecting: a connection being made is dropped.
     bool
     Connection::disconnect_()
     {
+        if ( closing_.exchange( true ) ) { return false; }
+        {
+            Guard   _guard(rmx_);
+            backoff_.notify_all();
+        }
+        beat_stop_();
+        if ( keep_.reconnect_ && !up_.load() )
+        {
+            down_();
+            return false;
+        }
         return transmit_( disconnect );
     }
 
+    //!> Headers go in a stack buffer, the payload as is: no copies.
     bool
-    Connection::send_( std::string const& data, EndPoint const& destination )
+    Connection::send_( std::string const& data, EndPoint const& destination, uint64_t receipt )
     {
-        std::ostringstream  _oss;
-        _oss << "SEND\ndestination:"
-             << destination.prefix()
-             << destination.dest_
-             << "\n\n"
-             << data
-             << "\0";
-        return transmit_( _oss.str() );
+        char        _prefix[256];
+        char        _receipt[32] = "";
+        std::string _long;
+        if ( receipt > 0 ) { ::snprintf( _receipt, sizeof(_receipt), "\nreceipt:%lu", (unsigned long)receipt ); }
+        int         _len(::snprintf( _prefix, sizeof(_prefix), "SEND\ndestination:%s%s%s\n\n",
+                                     destination.prefix(), destination.dest_.c_str(), _receipt ));
+        ::iovec     _iov[3]{{_prefix, size_t(_len)},
+                            {const_cast<char*>(data.data()), data.size()},
+                            {terminator, 1}};
+        if ( size_t(_len) >= sizeof(_prefix) ) // a long destination name
+        {
+            _long = std::string("SEND\ndestination:") + destination.prefix() + destination.dest_ + _receipt + "\n\n";
+            _iov[0] = {const_cast<char*>(_long.data()), _long.size()};
+        }
+        return keep_.reconnect_ ? publish_( _iov, 3 ) : transmit_( _iov, 3 );
+    }
+
+    /**
+     * While the connection is down, frames are held in the backlog,
+     * which resume_() sends (first) once it is back. A frame partly
+     * written when the connection went is sent again, whole.
+     */
+    bool
+    Connection::publish_( ::iovec const* iov, int count )
+    {
+        while ( true )
+        {
+            unsigned    _epoch(epoch_.load());
+            if ( up_.load() )
+            {
+                int     _err(write_( iov, count ));
+                if ( _err == 0 ) { return true; }
+                if ( !lost( _err ) )
+                {
+                    on_error( ::strerror( _err ), _err );
+                    return false;
+                }
+            }
+
+            Guard   _guard(bmx_);
+            if ( up_.load() )
+            {
+                if ( epoch_.load() != _epoch ) { continue; } // failed on the old one: try the new one
+                up_ = false;                                 // the dispatcher will notice too
+            }
+            size_t  _size(0);
+            for ( int _i(0); _i < count; ++_i ) { _size += iov[_i].iov_len; }
+            if ( backlog_.size() + _size > keep_.backlog_ ) { return false; }
+            for ( int _i(0); _i < count; ++_i ) { backlog_.append( static_cast<char const*>(iov[_i].iov_base), iov[_i].iov_len ); }
+            return true;
+        }
     }
 
     bool
-    Connection::subscribe_( EndPoint const& destination, int id )
+    Connection::subscribe_( EndPoint const& destination, int id, SubOptions const& options )
     {
         std::ostringstream  _oss;
         _oss << "SUBSCRIBE\ndestination:"
              << destination.prefix()
              << destination.dest_
              << "\nid:"
-             << id
-             << "\n\n\0";
+             << id;
+        switch ( options.ack_ )
+        {
+        case SubOptions::Ack::CLIENT:            _oss << "\nack:client"; break;
+        case SubOptions::Ack::CLIENT_INDIVIDUAL: _oss << "\nack:client-individual"; break;
+        case SubOptions::Ack::AUTO:              break;
+        }
+        if ( options.prefetch_ > 0 ) { _oss << "\nactivemq.prefetchSize:" << options.prefetch_; }
+        _oss << "\n\n\0";
         return transmit_( _oss.str() );
     }
 
+    bool
+    Connection::ack_( std::string const& frames )
+    {
+        ::iovec     _iov{const_cast<char*>(frames.data()), frames.size()};
+        return transmit_( &_iov, 1 );
+    }
+
     bool
     Connection::unsubscribe_( int id )
     {
@@ -316,11 +719,16 @@ namespace
         return transmit_( _oss.str() );
     }
 
-    Connection::~Connection() = default;
+    Connection::~Connection()
+    {
+        beat_stop_();
+    }
 
-    Connection::Connection(char const* host, int port)
+    Connection::Connection(char const* host, int port, Keepalive const& keepalive)
     : sockp_(std::make_unique<Socket>())
     , host_(host)
+    , port_(port)
+    , keep_(keepalive)
     {
         if ( !sockp_->connect( host, port ) )
         {
@@ -330,17 +738,116 @@ namespace
 
 // ----------------------------------------------------------------------
 
+    uint64_t
+    Receipts::acquire( Completion&& done )
+    {
+        Lock    _lock(mx_);
+        while ( !closed_ && tail_ - head_ >= slots_.size() ) { room_.wait( _lock ); }
+        if ( closed_ ) { return 0; }
+
+        uint64_t    _id(tail_++);
+        at_( _id ) = {std::move(done), true};
+        return _id;
+    }
+
+    //!> Unknown (or already completed) ids are ignored.
+    void
+    Receipts::complete( uint64_t id, bool ok )
+    {
+        Completion  _done;
+        {
+            Lock    _lock(mx_);
+            if ( id < head_ || id >= tail_ || !at_( id ).busy_ ) { return; }
+            Slot&   _slot(at_( id ));
+            _done = std::move(_slot.done_);
+            _slot = Slot();
+            while ( head_ < tail_ && !at_( head_ ).busy_ ) { ++head_; }
+            room_.notify_all();
+        }
+        if ( _done ) { _done( ok ); }
+    }
+
+    void
+    Receipts::fail_all()
+    {
+        std::vector<Completion> _failed;
+        {
+            Lock    _lock(mx_);
+            closed_ = true;
+            for ( ; head_ < tail_; ++head_ )
+            {
+                Slot&   _slot(at_( head_ ));
+                if ( _slot.busy_ ) { _failed.emplace_back( std::move(_slot.done_) ); }
+                _slot = Slot();
+            }
+            room_.notify_all();
+        }
+        for ( auto& _done : _failed ) { if ( _done ) { _done( false ); } }
+    }
+
+    void
+    Receipts::reopen()
+    {
+        Lock    _lock(mx_);
+        closed_ = false;
+    }
+
+    void
+    Receipts::resize( size_t window )
+    {
+        Lock    _lock(mx_);
+        while ( !closed_ && head_ < tail_ ) { room_.wait( _lock ); }
+        slots_.clear();
+        slots_.resize( std::max( window, size_t(1) ) );
+        room_.notify_all();
+    }
+
+    size_t
+    Receipts::max() const
+    {
+        Lock    _lock(mx_);
+        return slots_.size();
+    }
+
     bool
     Connection::start_stomp_()
     {
-        Frame   _frame;
+        if ( stomped_.exchange( true ) || !handshake_() ) { return false; }
+        up_ = true;
+        beat_start_();
+        return true;
+    }
+
+    /**
+     * Heart-beats as per STOMP 1.1: each way, the larger of what one
+     * side offers and the other wants, or none if either says 0.
+     */
+    bool
+    Connection::handshake_()
+    {
+        FrameView   _frame;
 
-        if ( stomped_.exchange( true ) ) { return false; }
         if ( stomp_() )
         {
             if ( reader_.read_frame( _frame, sockp_->fd_ ) )
             {
-                if ( _frame.verb_.find( "CONNECTED") != std::string::npos ) { return true; }
+                if ( _frame.is( "CONNECTED" ) )
+                {
+                    std::string_view    _beats(_frame.header( "heart-beat" ));
+                    long                _sx(0);
+                    long                _sy(0);
+                    auto                _comma(_beats.find( ',' ));
+                    if ( _comma != std::string_view::npos )
+                    {
+                        std::from_chars( _beats.data(), _beats.data() + _comma, _sx );
+                        std::from_chars( _beats.data() + _comma + 1, _beats.data() + _beats.size(), _sy );
+                    }
+                    out_  = keep_.beat_ > 0 && _sy > 0 ? std::max( keep_.beat_, _sy ) : 0;
+                    in_   = keep_.expect_ > 0 && _sx > 0 ? std::max( keep_.expect_, _sx ) : 0;
+                    Guard   _guard(pmx_);
+                    open_ = true;
+                    return true;
+                }
                 else {  std::cerr << _frame << std::endl; }
             }
             else { std::cerr << "Socket closed!" << std::endl; }
@@ -349,52 +856,187 @@ namespace
         return false;
     }
 
+    /**
+     * Backs off (doubling, with some jitter) between attempts, so a
+     * restarting broker is not stampeded. Only the dispatcher gets
+     * here: the reader is its own.
+     */
+    bool
+    Connection::reconnect_()
+    {
+        if ( !keep_.reconnect_ ) { return false; }
+        {
+            Guard   _guard(bmx_);
+            up_ = false;
+        }
+        beat_stop_();
+
+        thread_local std::minstd_rand   _random(std::random_device{}());
+        long    _delay(keep_.retry_);
+        while ( !closing_.load() )
+        {
+            {
+                Lock    _lock(rmx_);
+                long    _jitter(std::uniform_int_distribution<long>(0, _delay / 2)( _random ));
+                if ( backoff_.wait_for( _lock, std::chrono::milliseconds(_delay - _delay / 4 + _jitter),
+                                        [this]() { return closing_.load(); } ) ) { break; }
+            }
+            _delay = std::min( 2 * _delay, keep_.retryMax_ );
+
+            auto    _sockp(std::make_unique<Socket>());
+            if ( !_sockp->connect( host_.c_str(), port_ ) ) { continue; }
+            {
+                Lock    _lock(pmx_);
+                flushed_.wait( _lock, [this]() { return !flushing_; } );
+                sockp_.swap( _sockp ); // the old one closes on the way out
+                open_ = false;
+                ++epoch_;
+            }
+            reader_.reset();
+            if ( closing_.load() ) { down_(); } // DISCONNECT missed it: a read would hang
+            if ( handshake_() ) { return !closing_.load(); }
+        }
+        return false;
+    }
+
+    void
+    Connection::resume_()
+    {
+        receipts_.reopen();
+        {
+            Guard   _guard(bmx_);
+            if ( !backlog_.empty() )
+            {
+                ::iovec _iov{backlog_.data(), backlog_.size()};
+                if ( write_( &_iov, 1 ) != 0 ) { return; } // gone again: the dispatcher will see
+                backlog_.clear();
+            }
+            up_ = true;
+        }
+        beat_start_();
+    }
+
+    //!> The next read (or write) fails: dispatch and publishers take it from there.
+    void
+    Connection::down_()
+    {
+        Guard   _guard(pmx_);
+        ::shutdown( sockp_->fd_, SHUT_RDWR );
+    }
+
+    void
+    Connection::beat_start_()
+    {
+        Guard   _guard(rmx_);
+        if ( closing_.load() || (out_ == 0 && in_ == 0) ) { return; }
+        tick_    = std::max( std::min( out_ > 0 ? out_ : in_, in_ > 0 ? in_ : out_ ) / 2, 1L );
+        heard_   = now_ms();
+        bytes_   = reader_.received();
+        written_ = heard_;
+        pulse_   = std::make_shared<Pulse>();
+        pulse_->beat_ = [this]() { return beat_(); };
+        pulse_->tick_ = tick_;
+        beats().schedule( pulse_, tick_ );
+    }
+
+    //!> On return, no beat is running, and none will.
+    void
+    Connection::beat_stop_()
+    {
+        Guard   _guard(rmx_);
+        if ( !pulse_ ) { return; }
+        {
+            Guard   _beat(pulse_->mx_);
+            pulse_->beat_ = nullptr;
+        }
+        pulse_.reset();
+    }
+
+    /**
+     * On the scheduler thread. A heart-beat is only sent when nothing
+     * else is being, and without blocking: a full socket buffer says
+     * as much. Anything read at all (heart-beats included) counts.
+     */
+    bool
+    Connection::beat_()
+    {
+        int64_t     _now(now_ms());
+        if ( out_ > 0 && _now - written_.load( std::memory_order_relaxed ) + tick_ >= out_ )
+        {
+            Guard   _guard(pmx_);
+            if ( !flushing_ && open_ && ::send( sockp_->fd_, "\n", 1, MSG_DONTWAIT | MSG_NOSIGNAL ) == 1 )
+            {
+                written_.store( _now, std::memory_order_relaxed );
+            }
+        }
+        if ( in_ > 0 )
+        {
+            uint64_t    _bytes(reader_.received());
+            if ( _bytes != bytes_ )
+            {
+                bytes_ = _bytes;
+                heard_ = _now;
+            }
+            else
+            if ( _now - heard_ > 2 * in_ )
+            {
+                std::cerr << "No heart-beat from " << host_ << ':' << port_ << " for " << _now - heard_ << "ms" << std::endl;
+                down_();
+                return false;
+            }
+        }
+        return true;
+    }
+
     bool
-    Connection::post_( Frame& frame )
+    Connection::post_( FrameView const& frame )
     {
-        if ( frame.verb_.find( "MESSAGE" ) != std::string::npos )
+        if ( frame.is( "MESSAGE" ) )
         {
             return true;
         }
         else
-        if ( frame.verb_.find( "RECEIPT" ) != std::string::npos )
+        if ( frame.is( "RECEIPT" ) )
         {
-            std::cerr << frame << std::endl;
+            uint64_t    _id;
+            if ( receipt_id( frame, _id ) ) { receipts_.complete( _id, true ); }
+            else { std::cerr << frame << std::endl; }
         }
         else
-        if ( frame.verb_.find( "ERROR" ) != std::string::npos )
+        if ( frame.is( "ERROR" ) )
         {
+            uint64_t    _id;
+            if ( receipt_id( frame, _id ) ) { receipts_.complete( _id, false ); }
             std::cerr << frame << std::endl;
         }
         return false;
     }
 
     bool
-    Connection::unmarshall_( std::string& data, EndPoint& destination, Frame const& frame )
+    Connection::receive( FrameView& frame )
     {
-        auto    _pos1(frame.hdrs_.find( "destination:/" ));
-        if ( _pos1 == std::string::npos ) { return false; }
-        _pos1 += 13;  // strlen( "destination:/" )
-        bool    _isq(frame.hdrs_.compare( _pos1, 5, "queue" ) == 0);
-        _pos1 += 6;   // strlen( "queue/" )
-        auto    _pos2(frame.hdrs_.find( "\n", _pos1 ));
-        destination = {frame.hdrs_.substr( _pos1, _pos2 - _pos1 ), _isq};
-        data        = frame.body_;
-        return true;
+        return poll( frame ) == Reader::Read::FRAME;
     }
 
-    bool
-    Connection::receive( std::string& data, EndPoint& destination )
+    Reader::Read
+    Connection::poll( FrameView& frame, bool wait )
     {
-        Frame       _frame;
-
         while ( true )
         {
-            if ( !reader_.read_frame( _frame, sockp_->fd_ ) ) { return false; }
-            if ( post_( _frame ) ) { break; }
-            _frame.reset();
+            auto    _read(reader_.read_some( frame, sockp_->fd_, wait ));
+            if ( _read == Reader::Read::CLOSED ) // no more receipts, no more publishes
+            {
+                up_ = false;
+                receipts_.fail_all();
+            }
+            if ( _read != Reader::Read::FRAME || post_( frame ) ) { return _read; }
         }
-        return unmarshall_( data, destination, _frame );
+    }
+
+    int
+    Connection::fd() const
+    {
+        return sockp_->fd_;
     }
 
 // ======================================================================
@@ -426,6 +1068,7 @@ namespace
             started_.exchange( false );
             return false;
         }
+        if ( reactor_ ) { return reactor_->attach( *this ); }
         disp_ = std::thread(&Session::dispatch_, this);
         return true;
     }
@@ -437,17 +1080,73 @@ namespace
     }
 
     bool
-    Session::subscribe( EndPoint const& destination, Callback callback )
+    Session::subscribe( EndPoint const& destination, Callback callback, SubOptions const& options )
     {
-        int     _id(++id_);
+        return subscribe_view( destination, [callback]( std::string_view data, EndPoint const& endpoint )
+        {   // the copy the legacy signature needs, into a reused buffer
+            thread_local std::string    _data;
+            _data.assign( data.data(), data.size() );
+            callback( _data, endpoint );
+        }, options );
+    }
 
-        if ( conn_.subscribe_( destination, _id ) )
+    /**
+     * The table entry goes in before the SUBSCRIBE goes out, so the
+     * first message cannot miss it, and the reader with it, so that a
+     * concurrent subscribe to the same destination finds it. An
+     * existing subscription only gets the new callback.
+     */
+    bool
+    Session::subscribe_view( EndPoint const& destination, ViewCallback callback, SubOptions const& options )
+    {
+        auto    _sub(std::make_shared<Subscription>());
+        _sub->endpoint_ = destination;
+        _sub->callback_ = std::move(callback);
+        _sub->options_  = options;
+
+        SubPtr  _old;
         {
             Guard   _guard(mx_);
-            readers_.insert( {destination, {callback, _id}} );
+            auto    _itr(readers_.find( destination ));
+            if ( _itr != readers_.end() )
+            {
+                _old = _itr->second;
+                _sub->id_      = _old->id_;
+                _sub->options_ = _old->options_; // as the broker has it
+            }
+            else
+            if ( !free_.empty() )
+            {
+                _sub->id_ = free_.back();
+                free_.pop_back();
+            }
+            else { _sub->id_ = ++id_; }
+            if ( _sub->options_.ack_ != SubOptions::Ack::AUTO ) { _sub->acks_ = std::make_unique<Acks>(); }
+
+            install_( _sub->id_, _sub );
+            readers_[destination] = _sub;
         }
-        else { return false; }
-        return true;
+
+        if ( _old )
+        {
+            if ( _old->acks_ ) { ack_( *_old, std::string_view(), true ); }
+            return false;
+        }
+
+        if ( conn_.subscribe_( destination, _sub->id_, options ) || conn_.reconnects() ) // else, on reconnecting
+        {
+            return true;
+        }
+
+        Guard   _guard(mx_);
+        auto    _itr(readers_.find( destination ));
+        if ( _itr != readers_.end() && _itr->second->id_ == _sub->id_ ) // unless unsubscribed meanwhile
+        {
+            readers_.erase( _itr );
+            install_( _sub->id_, SubPtr() );
+            free_.push_back( _sub->id_ );
+        }
+        return false;
     }
 
     bool
@@ -458,17 +1157,74 @@ namespace
             Guard   _guard(mx_);
             auto _itr = readers_.find( destination );
             if ( _itr == readers_.end() ) { return false; }
-            _id = _itr->second.second;
+            _id = _itr->second->id_;
         }
         if ( conn_.unsubscribe_( _id ) )
         {
             Guard   _guard(mx_);
             readers_.erase( destination );
+            install_( _id, SubPtr() );
+            free_.push_back( _id );
             return true;
         }
         return false;
     }
 
+    void
+    Session::install_( int id, SubPtr const& subscription )
+    {
+        Table const*            _curr(routes_.load());
+        std::unique_ptr<Table>  _next(_curr ? new Table(*_curr) : new Table());
+        if ( _next->subs_.size() <= size_t(id) ) { _next->subs_.resize( id + 1 ); }
+        _next->subs_[id] = subscription;
+        routes_.store( _next.get() );
+        tables_.emplace_back( std::move(_next) );
+        if ( tables_.size() > 1 ) { retired_.store( true ); }
+    }
+
+    /**
+     * Read-copy-update: the dispatcher is the only reader, and between
+     * frames it holds no table. Any table but the current one was
+     * swapped out before, so none can be in use.
+     */
+    void
+    Session::reclaim_()
+    {
+        Guard   _guard(mx_);
+        retired_.store( false );
+        if ( tables_.size() > 1 ) { tables_.erase( tables_.begin(), tables_.end() - 1 ); }
+    }
+
+    //!> No lock, no copies: by the subscription header the broker echoes, or else by destination.
+    Session::SubPtr const*
+    Session::route_( FrameView const& frame ) const
+    {
+        std::string_view    _dest;
+        bool                _isq;
+        if ( !frame.destination( _dest, _isq ) ) { return nullptr; }
+
+        Table const*        _table(routes_.load( std::memory_order_acquire ));
+        if ( !_table ) { return nullptr; }
+
+        std::string_view    _value(frame.header( "subscription" ));
+        if ( _value.empty() ) // a 1.0 broker need not send it
+        {
+            for ( auto& _sub : _table->subs_ )
+            {
+                if ( _sub && _sub->endpoint_.isQ_ == _isq && _dest == _sub->endpoint_.dest_ ) { return &_sub; }
+            }
+            return nullptr;
+        }
+
+        unsigned            _id;
+        if ( std::from_chars( _value.data(), _value.data() + _value.size(), _id ).ec != std::errc() ) { return nullptr; }
+        if ( _id >= _table->subs_.size() ) { return nullptr; }
+        SubPtr const&       _sub(_table->subs_[_id]);
+
+        // an id can be reused: not for a message in flight to the old destination
+        return _sub && _sub->endpoint_.isQ_ == _isq && _dest == _sub->endpoint_.dest_ ? &_sub : nullptr;
+    }
+
     bool
     Session::publish( std::string const& data, EndPoint const& destination )
     {
@@ -478,31 +1234,208 @@ namespace
     }
 
     bool
-    Session::locate_( EndPoint const& destination, Callback& callback )
+    Session::publish( std::string const& data, EndPoint const& destination, Completion done )
     {
-        Guard   _guard(mx_);
-        auto    _itr(readers_.find( destination ));
-        if ( _itr != readers_.end() )
+        auto&       _receipts(conn_.receipts());
+        uint64_t    _id((started_.load() || start()) ? _receipts.acquire( std::move(done) ) : 0);
+        if ( _id == 0 ) // done was not taken
         {
-            callback = _itr->second.first;
-            return true;
+            if ( done ) { done( false ); }
+            return false;
         }
+        if ( conn_.send_( data, destination, _id ) ) { return true; }
+        _receipts.complete( _id, false );
         return false;
     }
 
+    std::future<bool>
+    Session::publish_async( std::string const& data, EndPoint const& destination )
+    {
+        auto    _promise(std::make_shared<std::promise<bool>>());
+        auto    _future(_promise->get_future());
+        publish( data, destination, [_promise]( bool ok ) { _promise->set_value( ok ); } );
+        return _future;
+    }
+
+    void
+    Session::set_max_in_flight( std::size_t max )
+    {
+        conn_.receipts().resize( max );
+    }
+
+    std::size_t
+    Session::max_in_flight() const
+    {
+        return conn_.receipts().max();
+    }
+
+    //!> Held back ACKs go out before we would block for more input.
     void
     Session::dispatch_()
     {
-        std::string _data;
-        EndPoint    _endpoint;
-        Callback    _callback;
+        FrameView   _frame;
 
         while ( !stopped_ )
         {
-            if ( !conn_.receive( _data, _endpoint ) ) { break; }
-            if ( locate_( _endpoint, _callback ) )
+            auto    _read(conn_.poll( _frame, !acking_ ));
+            if ( _read == Reader::Read::AGAIN )
+            {
+                flush_acks_();
+                continue;
+            }
+            if ( _read != Reader::Read::FRAME )
+            {
+                if ( stopped_ || !recover_() ) { break; }
+                continue;
+            }
+            deliver_( _frame );
+        }
+    }
+
+    void
+    Session::deliver_( FrameView const& frame )
+    {
+        if ( retired_.load( std::memory_order_relaxed ) ) { reclaim_(); }
+
+        SubPtr const*       _route(route_( frame ));
+        if ( !_route ) { return; }
+        Subscription const& _sub(**_route);
+
+        std::string_view    _msgid(_sub.acks_ ? frame.header( "message-id" ) : std::string_view());
+        if ( reactor_ && reactor_->pooled() ) // the view does not outlive this call, nor may the table
+        {
+            std::size_t _key(std::hash<std::string>()( _sub.endpoint_.dest_ ));
+            ++jobs_;
+            reactor_->post( _key, [this, _key, _sub = *_route, _body = std::string(frame.body_), _msgid = std::string(_msgid)]()
+            {
+                _sub->callback_( _body, _sub->endpoint_ );
+                if ( _sub->acks_ ) { ack_( *_sub, _msgid, reactor_->idle( _key ) ); }
+                --jobs_;
+            });
+        }
+        else
+        {
+            _sub.callback_( frame.body_, _sub.endpoint_ );
+            if ( _sub.acks_ ) { ack_( _sub, _msgid, false ); }
+        }
+    }
+
+    /**
+     * ACK frames accumulate per subscription: client-individual needs
+     * one per message, client (cumulative) only the latest.
+     */
+    struct Session::Acks
+    {
+        std::mutex  mx_;
+        std::string frames_; // client-individual
+        std::string last_;   // client
+        unsigned    count_{0};
+    };
+
+    Session::Subscription::~Subscription() = default;
+
+    void
+    Session::ack_( Subscription const& subscription, std::string_view id, bool flush )
+    {
+        thread_local std::string    _out;
+        Acks&                       _acks(*subscription.acks_);
+        auto                        _frame([&]( std::string& out, std::string_view msgid )
+        {
+            out.append( "ACK\nsubscription:" ).append( std::to_string( subscription.id_ ) )
+               .append( "\nmessage-id:" ).append( msgid.data(), msgid.size() ).append( "\n\n", 3 ); // with the NUL
+        });
+        {
+            std::lock_guard<std::mutex> _guard(_acks.mx_);
+            if ( !id.empty() )
+            {
+                if ( subscription.options_.ack_ == SubOptions::Ack::CLIENT ) { _acks.last_.assign( id.data(), id.size() ); }
+                else { _frame( _acks.frames_, id ); }
+                ++_acks.count_;
+            }
+            if ( _acks.count_ == 0 ) { return; }
+            if ( !flush && _acks.count_ < subscription.options_.batch_ )
+            {
+                acking_ = true;
+                return;
+            }
+
+            _out.clear();
+            if ( subscription.options_.ack_ == SubOptions::Ack::CLIENT ) { _frame( _out, _acks.last_ ); }
+            else
+            {
+                _out.assign( _acks.frames_ );
+                _acks.frames_.clear();
+            }
+            _acks.count_ = 0;
+        }
+        conn_.ack_( _out );
+    }
+
+    void
+    Session::flush_acks_()
+    {
+        if ( !acking_.exchange( false ) ) { return; }
+        if ( retired_.load( std::memory_order_relaxed ) ) { reclaim_(); }
+
+        if ( Table const* _table = routes_.load( std::memory_order_acquire ) )
+        {
+            for ( auto& _sub : _table->subs_ )
             {
-                _callback( _data, _endpoint );
+                if ( _sub && _sub->acks_ ) { ack_( *_sub, std::string_view(), true ); }
+            }
+        }
+    }
+
+    /**
+     * Same ids as before, so routes_ stands. ACKs held back were for
+     * the old connection, whose unacknowledged messages come again.
+     */
+    bool
+    Session::recover_()
+    {
+        if ( !conn_.reconnect_() ) { return false; }
+
+        std::vector<SubPtr> _subs;
+        {
+            Guard   _guard(mx_);
+            for ( auto& _entry : readers_ ) { _subs.push_back( _entry.second ); }
+        }
+        for ( auto& _sub : _subs )
+        {
+            if ( _sub->acks_ )
+            {
+                Guard   _guard(_sub->acks_->mx_);
+                _sub->acks_->frames_.clear();
+                _sub->acks_->count_ = 0;
+            }
+            conn_.subscribe_( _sub->endpoint_, _sub->id_, _sub->options_ );
+        }
+        conn_.resume_();
+        return true;
+    }
+
+    bool
+    Session::readable_()
+    {
+        FrameView   _frame;
+
+        while ( true )
+        {
+            switch ( conn_.poll( _frame ) )
+            {
+            case Reader::Read::FRAME:  deliver_( _frame ); break;
+            case Reader::Read::AGAIN:  flush_acks_(); return true;
+            case Reader::Read::CLOSED:
+                if ( !stopped_ && conn_.reconnects() ) // not on the loop thread: it would stall the others
+                {
+                    if ( rejoin_.joinable() ) { rejoin_.join(); } // done: we were attached again
+                    rejoin_ = std::thread([this]()
+                    {
+                        reactor_->detach( *this ); // waits out this batch
+                        if ( recover_() ) { reactor_->attach( *this ); }
+                    });
+                }
+                return false;
             }
         }
     }
@@ -511,11 +1444,19 @@ namespace
     {
         stop();
         stopped_ = true;
+        if ( rejoin_.joinable() ) { rejoin_.join(); }
+        if ( reactor_ ) { reactor_->detach( *this ); }
         if ( disp_.joinable() ) { disp_.join(); }
+        while ( jobs_.load() > 0 ) { std::this_thread::yield(); } // on reactor workers
     }
 
     Session::Session(Connection& conn)
     : conn_(conn)
     {}
 
+    Session::Session(Connection& conn, Reactor& reactor)
+    : conn_(conn)
+    , reactor_(&reactor)
+    {}
+
 } // namespace Stomp
@@ -9,16 +9,21 @@
 #define UTILITY_STOMP_H
 
 #include <string>
+#include <string_view>
 #include <mutex>
 #include <map>
 #include <functional>
 #include <thread>
 #include <memory>
 #include <atomic>
+#include <future>
+#include <algorithm>
 
 namespace Stomp
 {
     class Connection;
+    class Reactor;
+    struct FrameView;
 
     struct EndPoint
     {
@@ -28,15 +33,74 @@ namespace Stomp
         char const* prefix() const { return isQ_? "/queue/" : "/topic/"; }
     };
 
+    // transparent: lookups by name need not build an EndPoint
     struct EPComparator
     {
+        using is_transparent = void;
+
         bool operator()( EndPoint const& lhs, EndPoint const& rhs ) const
         {
             return lhs.dest_ < rhs.dest_;
         }
+        bool operator()( EndPoint const& lhs, std::string_view rhs ) const
+        {
+            return std::string_view(lhs.dest_) < rhs;
+        }
+        bool operator()( std::string_view lhs, EndPoint const& rhs ) const
+        {
+            return lhs < std::string_view(rhs.dest_);
+        }
     };
 
     using Callback = std::function<void(std::string const&, EndPoint const&)>;
+    // the view is into the receive buffer, valid only for the duration of the call
+    using ViewCallback = std::function<void(std::string_view, EndPoint const&)>;
+
+    /**
+     * Per subscription consumer settings. With client acknowledgement,
+     * messages are ACKed after their callback returns, in groups of up
+     * to batch_ (and whenever the dispatcher runs out of input).
+     */
+    struct SubOptions
+    {
+        enum class Ack : uint8_t { AUTO, CLIENT, CLIENT_INDIVIDUAL };
+
+        Ack         ack_{Ack::AUTO};
+        unsigned    prefetch_{0}; // activemq.prefetchSize (0: broker default)
+        unsigned    batch_{1};    // messages per round of ACKs
+
+        SubOptions& ack( Ack mode ) { ack_ = mode; return *this; }
+        SubOptions& prefetch( unsigned size ) { prefetch_ = size; return *this; }
+        SubOptions& batch( unsigned count ) { batch_ = count > 0 ? count : 1; return *this; }
+    };
+
+    /**
+     * Connection liveness. Heart-beats (STOMP 1.1) are offered as
+     * beat_/expect_ and settled by the broker's CONNECTED; a broker
+     * silent for twice the agreed period is taken for dead. With
+     * reconnect_, a lost connection is made again, backing off from
+     * retry_ to retryMax_, subscriptions are replayed, and publishes
+     * made meanwhile are held, up to backlog_ bytes, and then sent.
+     * Those already written to a connection that dies are lost: only
+     * a receipt says a message got there.
+     */
+    struct Keepalive
+    {
+        long        beat_{0};         // ms between our heart-beats (0: none)
+        long        expect_{0};       // ms between the broker's (0: none)
+        bool        reconnect_{false};
+        long        retry_{100};      // ms, doubled per failed attempt
+        long        retryMax_{30000};
+        std::size_t backlog_{std::size_t(4) << 20};
+
+        Keepalive& heartbeat( long beat, long expect ) { beat_ = beat; expect_ = expect; return *this; }
+        Keepalive& reconnect( long retry = 100, long retryMax = 30000 )
+                                      { reconnect_ = true; retry_ = std::max( retry, 1L ); retryMax_ = std::max( retryMax, retry_ ); return *this; }
+        Keepalive& backlog( std::size_t bytes ) { backlog_ = bytes; return *this; }
+    };
+
+    // broker receipt for a pipelined publish: true on RECEIPT, false on ERROR or disconnect
+    using Completion = std::function<void(bool)>;
 
     template<typename... Args>
     Callback
@@ -56,38 +120,85 @@ namespace Stomp
     public:
         ~Session() noexcept;
         Session(Connection&);
+        Session(Connection&, Reactor&); // start() attaches to the reactor: no thread
 
         bool start( EndPoint const&, Callback ); // run dispatch from outside
         bool start();                            // run dispatch internally
         bool stop();
 
         // true on new subscription, false on old (callback replaced)
-        bool subscribe( EndPoint const& destination, Callback callback );
+        bool subscribe( EndPoint const& destination, Callback callback, SubOptions const& options = SubOptions() );
+        // as above, but without copying the message body
+        bool subscribe_view( EndPoint const& destination, ViewCallback callback, SubOptions const& options = SubOptions() );
         // true if destination was registered
         bool unsubscribe( EndPoint const& destination );
 
         // true if write succeeded
         bool publish( std::string const& data, EndPoint const& destination );
+        // pipelined: done is called once, on the dispatch thread when the broker confirms.
+        // Blocks while max_in_flight() messages await confirmation (so not from a callback).
+        bool publish( std::string const& data, EndPoint const& destination, Completion done );
+        std::future<bool> publish_async( std::string const& data, EndPoint const& destination );
+
+        void set_max_in_flight( std::size_t max );
+        std::size_t max_in_flight() const;
 
     private:
         using Mutex   = std::mutex;
         using Id      = std::atomic<int>;
-        using Pair    = std::pair<Callback, int>;
-        using Readers = std::map<EndPoint const, Pair, EPComparator>;
+        struct Acks; // pending acknowledgements
+        struct Subscription
+        {
+            EndPoint                endpoint_;
+            ViewCallback            callback_;
+            int                     id_;
+            SubOptions              options_;
+            std::unique_ptr<Acks>   acks_; // client modes only
+
+            ~Subscription() noexcept;
+        };
+        using SubPtr  = std::shared_ptr<Subscription const>;
+        using Readers = std::map<EndPoint const, SubPtr, EPComparator>;
         using Worker  = std::thread;
         using Boolean = std::atomic<bool>;
+        // routing: subscriptions by id, copied on write and swapped in whole
+        struct Table
+        {
+            std::vector<SubPtr> subs_;
+        };
+        using Routes  = std::atomic<Table const*>;
+        using Tables  = std::vector<std::unique_ptr<Table const>>;
+        using Ids     = std::vector<int>;
 
-        Mutex       mx_;
+        Mutex       mx_;      // for readers_ and table updates
         Connection& conn_;
-        Id          id_{ATOMIC_VAR_INIT(0)};
+        Reactor*    reactor_{nullptr};
+        int         id_{0};   // last id issued
+        Ids         free_;    // ids of dropped subscriptions, reused first
         Readers     readers_;
+        Routes      routes_{nullptr};
+        Tables      tables_;  // the current one last; the others retired, and
+                              // freed by the dispatcher once it holds none
+        Boolean     retired_{ATOMIC_VAR_INIT(false)};
         Worker      disp_;
+        Worker      rejoin_;  // reattaches to the reactor after a reconnect
         Boolean     started_{ATOMIC_VAR_INIT(false)};
         bool        manual_{false}; // which way were we started
-        bool        stopped_{false};
+        Boolean     stopped_{ATOMIC_VAR_INIT(false)};
+        Boolean     acking_{ATOMIC_VAR_INIT(false)}; // some ACKs held back
+        std::atomic<int>    jobs_{0};  // queued on reactor workers
 
-        bool locate_( EndPoint const& destination, Callback& callback );
+        SubPtr const* route_( FrameView const& frame ) const;
+        void install_( int id, SubPtr const& subscription ); // with mx_ held
+        void reclaim_();  // from the dispatcher, between frames
         void dispatch_();
+        bool recover_();  // reconnect, and subscribe all over again
+        void deliver_( FrameView const& frame );
+        void ack_( Subscription const& subscription, std::string_view id, bool flush );
+        void flush_acks_();
+        bool readable_(); // from the Reactor: false when the peer has gone
+
+        friend class Reactor;
 
         Session(Session const&) = delete;
         Session& operator=( Session const& ) = delete;
@@ -21,9 +21,15 @@ namespace Stomp
     }
 
     bool
-    StompAgent::subscribe( EndPoint const& src, Callback cb )
+    StompAgent::subscribe( EndPoint const& src, Callback cb, SubOptions const& opts )
     {
-        return sess_.subscribe( src, cb );
+        return sess_.subscribe( src, cb, opts );
+    }
+
+    bool
+    StompAgent::subscribe_view( EndPoint const& src, ViewCallback cb, SubOptions const& opts )
+    {
+        return sess_.subscribe_view( src, std::move(cb), opts );
     }
 
     bool
@@ -38,6 +44,24 @@ namespace Stomp
         return sess_.publish( msg, tgt );
     }
 
+    bool
+    StompAgent::publish( EndPoint const& tgt, std::string const& msg, Completion done )
+    {
+        return sess_.publish( msg, tgt, std::move(done) );
+    }
+
+    std::future<bool>
+    StompAgent::publish_async( EndPoint const& tgt, std::string const& msg )
+    {
+        return sess_.publish_async( msg, tgt );
+    }
+
+    void
+    StompAgent::set_max_in_flight( std::size_t max )
+    {
+        sess_.set_max_in_flight( max );
+    }
+
     StompAgent::~StompAgent()
     {
         sess_.stop();
@@ -45,12 +69,20 @@ namespace Stomp
 
     StompAgent::StompAgent(bool startnow, Credentials const& cred)
     : cred_(cred)
-    , conn_(cred_.host_.c_str(), cred.port_)
+    , conn_(cred_.host_.c_str(), cred.port_, cred.keepalive_)
     , sess_(conn_)
     {
         if ( startnow ) { start(); }
     }
 
+    StompAgent::StompAgent(Reactor& reactor, bool startnow, Credentials const& cred)
+    : cred_(cred)
+    , conn_(cred_.host_.c_str(), cred.port_, cred.keepalive_)
+    , sess_(conn_, reactor)
+    {
+        if ( startnow ) { start(); }
+    }
+
 
 
 } // namespace Stomp
@@ -9,6 +9,7 @@
 #define AMS_STOMPAGENT_H
 
 #include "StompImpl.h"
+#include "Reactor.h"
 
     /**
      * @file: StompAgent.h
@@ -58,6 +59,7 @@ namespace
     {
         std::string         user_{""};
         std::string         pass_{""};
+        Keepalive           keepalive_;
         //
         ~Credentials() = default;
         Credentials() = default;
@@ -70,6 +72,7 @@ namespace
         Credentials& pass( std::string const& pass ) { pass_ = pass; return *this; }
         Credentials& uspw( std::string const& user, std::string const& pass )
                                                      { user_ = user; pass_ = pass; return *this; }
+        Credentials& keepalive( Keepalive const& keepalive ) { keepalive_ = keepalive; return *this; }
     };
 
     class StompAgent
@@ -79,14 +82,22 @@ namespace
 
         explicit
         StompAgent(bool startnow = false, Credentials const& = Credentials());
+        // no dispatch thread: the reactor delivers
+        explicit
+        StompAgent(Reactor& reactor, bool startnow = false, Credentials const& = Credentials());
 
         bool start();                            // start dispatch in another thread
         bool start( EndPoint const&, Callback ); // start dispatch here
 
-        bool subscribe( EndPoint const& source, Callback handler );
+        bool subscribe( EndPoint const& source, Callback handler, SubOptions const& options = SubOptions() );
+        bool subscribe_view( EndPoint const& source, ViewCallback handler, SubOptions const& options = SubOptions() ); // zero-copy
         bool unsubscribe( EndPoint const& source );
 
         bool publish( EndPoint const& target, std::string const& message );
+        // pipelined, confirmed by broker receipt
+        bool publish( EndPoint const& target, std::string const& message, Completion done );
+        std::future<bool> publish_async( EndPoint const& target, std::string const& message );
+        void set_max_in_flight( std::size_t max );
 
     private:
         Credentials     cred_;
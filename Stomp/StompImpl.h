@@ -9,46 +9,188 @@
 #define UTILITY_STOMPIMPL_H
 
 #include "Stomp.h"
-#include "WaitQueue.h"
 
 #include <string>
+#include <string_view>
 #include <map>
+#include <vector>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
 #include <atomic>
+#include <iosfwd>
+#include <cstdint>
+#include <sys/types.h>
+#include <sys/uio.h>
 
 namespace Stomp
 {
 
     struct Socket;
-    struct Frame;
+    struct Pulse;
 
     /**
-     * For unmarshalling Frames
+     * A received frame, as views into the Reader buffer.
+     * Valid until the next read_frame(), i.e. for one dispatch.
+     * Header values are raw (STOMP 1.1 escapes are not undone).
+     */
+    struct FrameView
+    {
+        enum { MAXHEADERS = 32 }; // any more are dropped (content-length is still honoured)
+
+        struct Header
+        {
+            std::string_view    key_;
+            std::string_view    value_;
+        };
+
+        std::string_view    verb_;
+        Header              hdrs_[MAXHEADERS];
+        size_t              count_{0};
+        std::string_view    body_;
+
+        // first occurrence wins, as per the spec
+        std::string_view header( std::string_view key ) const
+        {
+            for ( size_t _i(0); _i < count_; ++_i )
+            {
+                if ( hdrs_[_i].key_ == key ) { return hdrs_[_i].value_; }
+            }
+            return std::string_view();
+        }
+        bool is( std::string_view verb ) const { return verb_ == verb; }
+        // "/queue/name" or "/topic/name"
+        bool destination( std::string_view& name, bool& isQ ) const;
+    };
+
+    std::ostream& operator<<( std::ostream& os, FrameView const& frame );
+
+    /**
+     * For unmarshalling Frames: one pass over the headers,
+     * picking up content-length on the way. Resumable: when a frame
+     * is incomplete, the next call carries on where this one stopped.
+     * What has been parsed so far is kept here, as offsets from the
+     * start of the frame: the bytes may have moved in between (as long
+     * as the frame still begins at start), and any FrameView will do.
+     * Complete frames, the common case, never take that detour.
      */
     struct Framer
     {
-        char*           eoh_{nullptr};  // end of headers
+        enum class Stage : uint8_t { START, HEADERS, BODY };
+
+        struct Span
+        {
+            uint32_t    key_;   // offsets into the frame
+            uint32_t    value_;
+            uint32_t    klen_;
+            uint32_t    vlen_;
+        };
+
+        Stage           stage_{Stage::START};
+        size_t          skip_{0};       // EOLs (heart-beats) ahead of the frame
+        size_t          scan_{0};       // frame bytes already examined
+        size_t          body_{0};       // frame offset of the body
         size_t          len_{0};        // content length
         bool            havecl_{false}; // whether len_ is defined
+        size_t          verb_{0};       // length (at offset 0) of a suspended frame's verb
+        size_t          count_{0};      // of hdrs_
+        Span            hdrs_[FrameView::MAXHEADERS]; // of a suspended frame
 
-        size_t fill_frame( char* start, char* end, Frame& );
-        Framer& reset() { return *this = Framer(); }
+        // bytes consumed for a complete frame (then in the FrameView), else 0
+        size_t fill_frame( char const* start, char const* end, FrameView& );
+        size_t suspend_( char const* start, FrameView const& frame );
+        void resume_( char const* start, FrameView& frame ) const;
+        Framer& reset()
+        {
+            stage_  = Stage::START;
+            skip_   = scan_ = body_ = len_ = 0;
+            havecl_ = false;
+            return *this;
+        }
     };
 
     /**
-     * Inbound read buffer management
+     * Inbound read buffer management.
+     * A ring whose pages are mapped twice, back to back, so that any
+     * RINGSIZE bytes from any position are contiguous: frames never wrap,
+     * and nothing is moved. A frame that outgrows the ring is moved to
+     * a growable side buffer until it (and what follows) is consumed.
      */
     struct Reader
     {
-        enum    { BUFFERSIZE = 100007 };
-        char    buffer_[BUFFERSIZE + 1]; // extra for sentinel
-        char*   fillpt_{buffer_};        // fill point for reads
-        size_t  done_{0};                // alread parsed
-        size_t  left_{0};                // not parsed
-        Framer  parser_;                 // finds frame boundaries
-        bool    parsing_{false};         // internal state
-
-        bool read_frame( Frame& frame, int fd );
+        enum : size_t { RINGSIZE = size_t(1) << 20, MAXFRAME = size_t(1) << 30 };
+
+        ~Reader() noexcept;
+        Reader();
+
+        enum class Read : uint8_t { FRAME, AGAIN, CLOSED };
+
+        // AGAIN only on a non-blocking fd, once it has been drained
+        Read read_some( FrameView& frame, int fd, bool wait = true ); // !wait: AGAIN rather than block
+        bool read_frame( FrameView& frame, int fd ) { return read_some( frame, fd ) == Read::FRAME; }
+        uint64_t received() const { return bytes_.load( std::memory_order_relaxed ); } // ever, from any thread
+        void reset();                                                                    // for a new connection
+
+    private:
+        using Spill = std::unique_ptr<char[]>;
+
+        char*       ring_{nullptr};
+        uint64_t    head_{0};         // consumed (monotonic)
+        uint64_t    tail_{0};         // received (monotonic)
+        Spill       spill_;           // oversized frames
+        size_t      scap_{0};         // spill_ capacity
+        size_t      slen_{0};         // spill_ received
+        size_t      sdone_{0};        // spill_ consumed
+        bool        spilling_{false};
+        Framer      parser_;          // finds frame boundaries
+        std::atomic<uint64_t>   bytes_{0}; // for liveness checks
+
+        char* at_( uint64_t offset ) const { return ring_ + (offset & (RINGSIZE - 1)); }
+        bool next_( FrameView& frame );
+        ssize_t load_( int fd, int flags );
+        bool spill_grow_( size_t need ); // false: too large
+
+        Reader(Reader const&) = delete;
+        Reader& operator=( Reader const& ) = delete;
+    };
+
+    /**
+     * Outstanding receipts, in a window of at most max() slots indexed
+     * by id modulo the window; ids are issued in order, from 1.
+     * acquire() blocks while the window is full (backpressure).
+     */
+    class Receipts
+    {
+    public:
+        enum : size_t { WINDOW = 1024 };
+
+        ~Receipts() noexcept { fail_all(); }
+        explicit Receipts(size_t window = WINDOW) : slots_(window) {}
+
+        uint64_t acquire( Completion&& done ); // 0 if closed
+        void complete( uint64_t id, bool ok );
+        void fail_all();                       // the connection is gone
+        void reopen();                         // and is back
+        void resize( size_t window );          // waits for outstanding receipts
+        size_t max() const;
+
+    private:
+        using Lock = std::unique_lock<std::mutex>;
+
+        struct Slot
+        {
+            Completion  done_;
+            bool        busy_{false};
+        };
+
+        std::mutex mutable      mx_;
+        std::condition_variable room_;
+        std::vector<Slot>       slots_;
+        uint64_t                head_{1}; // oldest outstanding
+        uint64_t                tail_{1}; // next to issue
+        bool                    closed_{false};
+
+        Slot& at_( uint64_t id ) { return slots_[id % slots_.size()]; }
     };
 
     /**
@@ -60,33 +202,76 @@ namespace Stomp
     {
     public:
         ~Connection() noexcept;
-        Connection(char const* host, int port);
+        Connection(char const* host, int port, Keepalive const& keepalive = Keepalive());
 
         bool start_stomp_();
-        bool receive( std::string& data, EndPoint& destination );
+        bool reconnect_(); // backs off until connected and STOMPed again; false once closing
+        void resume_();    // subscriptions are back: held publishes go, then everyone's
+        bool reconnects() const { return keep_.reconnect_; }
+        bool receive( FrameView& frame ); // true for a MESSAGE
+        Reader::Read poll( FrameView& frame, bool wait = true ); // FRAME for a MESSAGE; does not block when non-blocking
+        int fd() const;
+        Receipts& receipts() { return receipts_; }
 
         // STOMP 1.1 verbs
-        bool send_( std::string const& data, EndPoint const& destination );
-        bool subscribe_( EndPoint const& destination, int id );
+        bool send_( std::string const& data, EndPoint const& destination, uint64_t receipt = 0 );
+        bool subscribe_( EndPoint const& destination, int id, SubOptions const& options = SubOptions() );
+        bool ack_( std::string const& frames ); // preformatted, each with its NUL
         bool unsubscribe_( int id );
         bool disconnect_();
 
     private:
-        using SockPtr = std::unique_ptr<Socket>;
-        using Writers = Utility::WaitQueue;
-        using Boolean = std::atomic<bool>;
+        struct Pending;
+        using SockPtr   = std::unique_ptr<Socket>;
+        using Boolean   = std::atomic<bool>;
+        using Mutex     = std::mutex;
+        using Condition = std::condition_variable;
+        using Batch     = std::vector<Pending*>;
+        using IOVecs    = std::vector<::iovec>;
 
         SockPtr     sockp_;
         std::string host_;
+        int         port_;
+        Keepalive   keep_;
         //
-        Writers     writers_; // serializes access to ::send()
+        Mutex       pmx_;             // for the writers' queue
+        Condition   flushed_;         // a flush round is over
+        Batch       pending_;         // queued for the next round
+        Batch       batch_;           // being written
+        IOVecs      iovs_;            // gathered for sendmsg()
+        bool        flushing_{false};
+        bool        open_{false};     // STOMPed: anyone may write
         Reader      reader_;  // fills a Frame
+        Receipts    receipts_; // pipelined publishes
         Boolean     stomped_{ATOMIC_VAR_INIT(false)}; // prevent dups
+        // liveness
+        Boolean     up_{ATOMIC_VAR_INIT(false)};      // publishes go out (else to backlog_)
+        Boolean     closing_{ATOMIC_VAR_INIT(false)}; // DISCONNECT: no more reconnects
+        std::atomic<unsigned>   epoch_{0};           // connections made
+        long        out_{0};          // negotiated heart-beat periods, ms
+        long        in_{0};
+        long        tick_{0};
+        std::atomic<int64_t>    written_{0};         // last write, steady ms
+        int64_t     heard_{0};        // last read, per the heart-beat checks
+        uint64_t    bytes_{0};
+        std::shared_ptr<Pulse>  pulse_;
+        Mutex       rmx_;             // for pulse_, and the backoff
+        Condition   backoff_;
+        Mutex       bmx_;             // for backlog_
+        std::string backlog_;         // frames held while disconnected
 
         bool stomp_();
+        bool handshake_();
+        int write_( ::iovec const* iov, int count, bool force = false ); // 0 or an errno
+        bool transmit_( ::iovec const* iov, int count );
         bool transmit_( std::string const& data );
-        bool unmarshall_( std::string&, EndPoint&, Frame const& ); // for message
-        bool post_( Frame& );
+        int flush_( Batch const& batch );
+        bool post_( FrameView const& );
+        bool publish_( ::iovec const* iov, int count );
+        void beat_start_();
+        void beat_stop_();
+        bool beat_();
+        void down_();
     };
 
 } // namespace Stomp
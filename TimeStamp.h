@@ -19,6 +19,7 @@ namespace Utility
         }
         
         operator std::string const() const { return std::string(buffer_); }
+        char const* c_str() const { return buffer_; }
         
         std::ostream& output( std::ostream& os ) const { return os << buffer_; }
     
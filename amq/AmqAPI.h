@@ -277,6 +277,13 @@ namespace ams
         explicit operator bool() const { return ptr_.get() != nullptr; }
         //
         cms::TextMessage* get() { return ptr_.get(); }        
+        //!> For reuse, once sent: CMS sends a copy
+        TextMessagePtr& reset( std::string const& text )
+        {
+            ptr_->clearBody();
+            ptr_->setText( text );
+            return *this;
+        }
     };
 } // namespace ams
 
@@ -6,6 +6,10 @@
 
 #include "AmqAgent.h"
 
+#include <cms/DeliveryMode.h>
+
+#include <algorithm>
+
 namespace ams
 {
 //=========================================================================
@@ -32,18 +36,34 @@ namespace ams
     }
 
 //=========================================================================
+    SendMap::Target::Target(SessionPtr& sp, EndPoint const& ep, bool persistent)
+    : name_(ep.dest_)
+    , isTopic_(ep.isTopic_)
+    , producer_(sp, ep)
+    , message_(sp, std::string())
+    {
+        producer_->setDeliveryMode( persistent ? cms::DeliveryMode::PERSISTENT : cms::DeliveryMode::NON_PERSISTENT );
+    }
+
+    //!> A name can be a topic and a queue both: the last one used is kept.
     SendMap::Target&
     SendMap::get( EndPoint const& ep, SessionPtr& sp )
     {
-        auto _itr(map_.find( ep.dest_ ));
-        if ( _itr != map_.end() ) { return _itr->second; }
-        return map_[ep.dest_].reset( sp, ep );
+        auto    _itr(map_.find( std::string_view(ep.dest_) ));
+        if ( _itr != map_.end() )
+        {
+            if ( _itr->second->isTopic_ == ep.isTopic_ ) { return *_itr->second; }
+            map_.erase( _itr );
+        }
+        auto                _target(std::make_unique<Target>(sp, ep, persistent_));
+        std::string_view    _key(_target->name_);
+        return *map_.emplace( _key, std::move(_target) ).first->second;
     }
 
     void
     SendMap::drop( std::string const& dest )
     {
-        map_.erase( dest );
+        map_.erase( std::string_view(dest) );
     }
 
 //=========================================================================
@@ -70,17 +90,26 @@ namespace ams
 
 //=========================================================================
     AmqAgent::AmqAgent(Credentials const& cred)
+    : AmqAgent(cred, 1)
+    {}
+
+    AmqAgent::AmqAgent(Credentials const& cred, std::size_t sessions)
     : cred_(cred)
     , conn_(cred_.broker_)
     , sess_(conn_)
+    , indexer_(std::max( sessions, std::size_t(1) ))
     , scope_(conn_)
-    , sender_(sess_)
     {
         if ( conn_ )
         {
             conn_->addTransportListener( &logger_ );
             conn_->setExceptionListener( &logger_ );
         }
+        if ( sessions > 1 )
+        {
+            pool_.reserve( sessions );
+            for ( std::size_t _i(0); _i < sessions; ++_i ) { pool_.emplace_back( conn_ ); }
+        }
     }
 
     AmqAgent&
@@ -92,14 +121,14 @@ namespace ams
     }
 
     AmqAgent&
-    AmqAgent::subscribe( EndPoint const& ep, cms::MessageListener* listener )
+    AmqAgent::subscribe( EndPoint const& ep, cms::MessageListener* listener, std::size_t weight )
     {
         if ( listener )
         {
             auto    _itr(rcvrs_.find( ep.dest_ ));
             if ( _itr == rcvrs_.end() )
             {
-                rcvrs_[ep.dest_].reset( listener, sess_, ep );
+                rcvrs_[ep.dest_].reset( listener, pick_( weight ), ep );
             }
             else { _itr->second.reset( listener ); }
         }
@@ -107,12 +136,17 @@ namespace ams
         return *this;
     }
 
+    //!> A resubscription stays where it is: weights are never given back.
+    SessionPtr&
+    AmqAgent::pick_( std::size_t weight )
+    {
+        return pool_.empty() ? sess_ : pool_[indexer_( weight )];
+    }
+
     AmqAgent&
     AmqAgent::publish( EndPoint const& ep, std::string const& text )
     {   // demonstrates the utter silliness of Java-izing a C++ API
-        DestinationPtr&    _dest(tgts_.get( ep, sess_ ));
-        TextMessagePtr     _msg(sess_, text);
-        sender_->send( _dest.get(), _msg.get() );
+        tgts_.get( ep, sess_ ).send( text );
         return *this;
     }
 
@@ -140,10 +174,10 @@ namespace ams
         auto    _bptr(dynamic_cast<cms::BytesMessage const*>(_mp.get()));
         if ( _bptr )
         {
-            int                         _len(_bptr->getBodyLength());
-            std::vector<unsigned char>  _vec(_len, '\0');
-            _bptr->readBytes( _vec );
-            return std::string(reinterpret_cast<char*>(_vec.data()), _len);
+            int         _len(_bptr->getBodyLength());
+            std::string _body(_len, '\0');
+            if ( _len > 0 ) { _bptr->readBytes( reinterpret_cast<unsigned char*>(&_body[0]), _len ); }
+            return _body;
         }
         // give up
         return "";
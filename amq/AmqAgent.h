@@ -9,10 +9,14 @@
 #define AMS_AMQAGENT_H
 
 #include "AmqAPI.h"
+#include "Distributor.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <memory>
 
     /**
      * @file AmqAgent.h
@@ -81,37 +85,62 @@ namespace
         void reset( cms::MessageListener* listener, SessionPtr& sess, EndPoint const& ep );
     };
 
+    /**
+     * @class SendMap
+     * @brief Producers bound to their destinations, by name.
+     * Keys are views of the names the targets hold, so a lookup
+     * allocates nothing. Each target recycles one message.
+     */
     class SendMap
     {
     public:
-        using Target = DestinationPtr;
-        using Map    = std::map<std::string const, Target>;
+        struct Target
+        {
+            std::string         name_;     // the key views this
+            bool                isTopic_;
+            BoundProducerPtr    producer_;
+            TextMessagePtr      message_;
+
+            Target(SessionPtr& sp, EndPoint const& ep, bool persistent);
+
+            void send( std::string const& text ) { producer_->send( message_.reset( text ).get() ); }
+        };
+        using TargetPtr = std::unique_ptr<Target>;
+        using Map       = std::unordered_map<std::string_view, TargetPtr>;
         //
         ~SendMap() noexcept = default;
-        SendMap() = default;
+        explicit SendMap(bool persistent = true) : persistent_(persistent) {}
         //
         Target& get( EndPoint const& dest, SessionPtr& sp );
         void drop( std::string const& dest );
         
     private:
         Map     map_;
+        bool    persistent_;
     };
 
     /**
      * AmqAgent
      * @brief All-in-one simple client: one producer, multi consumer (one per subscription)
+     * Pooled, consumers are spread over several sessions on the one
+     * connection. CMS dispatches a session's messages on a thread of
+     * its own, so listeners on different sessions run in parallel.
+     * Each subscription goes to the session with the least weight
+     * (expected share of traffic) so far, as per Utility::Indexer.
      */
     class AmqAgent
     {
         using RecvMap   = std::map<std::string const, Receiver>;
         using ConnScope = StartStop<ConnectionPtr>;
+        using Sessions  = std::vector<SessionPtr>;
     public:
         ~AmqAgent() = default;
         
         explicit AmqAgent(Credentials const& cred);
+        AmqAgent(Credentials const& cred, std::size_t sessions); // consumer sessions, if more than one
         AmqAgent(Credentials const& cred, activemq::transport::TransportListener* transportListener, cms::ExceptionListener* exceptionListener);
 
-        AmqAgent& subscribe( EndPoint const& endpoint, cms::MessageListener* listener );
+        AmqAgent& subscribe( EndPoint const& endpoint, cms::MessageListener* listener, std::size_t weight = 1 );
         AmqAgent& unsubscribe( EndPoint const& endpoint, bool release = false );
         // Rule of Five
         AmqAgent(AmqAgent const&) = delete;
@@ -119,22 +148,27 @@ namespace
         AmqAgent& operator=( AmqAgent const& ) = delete;
         AmqAgent& operator=( AmqAgent&& ) = default;
         //
-        explicit operator bool() const { return conn_ && sess_ && sender_; }
+        explicit operator bool() const { return conn_ && sess_; }
 
         AmqAgent& publish( EndPoint const& endpoint, std::string const& text );
         AmqAgent& purge( EndPoint const& endpoint, bool keep = false ); // for cached publish targets
 
         std::string one_shot( std::string const& topic );
 
+        std::size_t sessions() const { return pool_.empty() ? 1 : pool_.size(); }
+
     private: // Order alert! This is for safety in destructor sequence
         Credentials     cred_;
         ExceptionLogger logger_; // must outlive connection
         ConnectionPtr   conn_;
         SessionPtr      sess_;
+        Sessions        pool_;   // for consumers, when pooled
+        Utility::Indexer indexer_; // picks from pool_
         ConnScope       scope_;  // connection activation
-        SendMap         tgts_;   // publish topic cache
-        ProducerPtr     sender_; // publisher, need only one
+        SendMap         tgts_;   // publishers, by destination
         RecvMap         rcvrs_;  // subscribers, could have more than one
+
+        SessionPtr& pick_( std::size_t weight );
     };
 
     /**
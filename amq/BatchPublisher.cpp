@@ -0,0 +1,131 @@
+/** ======================================================================+
+ + Copyright @2020-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+
+#include "BatchPublisher.h"
+#include "Logging.h"
+
+#include <exception>
+
+namespace ams
+{
+//=========================================================================
+    BatchPublisher::~BatchPublisher() noexcept
+    {
+        {
+            Lock    _lock(mx_);
+            stopped_ = true;
+        }
+        armed_.notify_all();
+        if ( timer_.joinable() ) { timer_.join(); }
+        try { flush(); } catch (...) {}
+    }
+
+    BatchPublisher::BatchPublisher(Credentials const& cred, Limits const& limits, bool persistent)
+    : cred_(cred)
+    , conn_(cred_.broker_)
+    , sess_(conn_, cms::Session::SESSION_TRANSACTED)
+    , scope_(conn_)
+    , tgts_(persistent)
+    , limits_(limits)
+    {
+        if ( conn_ )
+        {
+            conn_->addTransportListener( &logger_ );
+            conn_->setExceptionListener( &logger_ );
+            if ( !persistent ) { conn_->setUseAsyncSend( true ); }
+        }
+        if ( limits_.millis_ > 0 ) { timer_ = std::thread(&BatchPublisher::run_, this); }
+    }
+
+    bool
+    BatchPublisher::publish( EndPoint const& ep, std::string const& text, Completion done )
+    {
+        Lock    _lock(mx_);
+        try { tgts_.get( ep, sess_ ).send( text ); }
+        catch (cms::CMSException&) { return false; }
+
+        if ( count_++ == 0 )
+        {
+            first_ = Clock::now();
+            armed_.notify_one();
+        }
+        bytes_ += text.size();
+        if ( done ) { dones_.emplace_back( std::move(done) ); }
+        if ( count_ >= limits_.count_ || bytes_ >= limits_.bytes_ ) { commit_( _lock ); }
+        return true;
+    }
+
+    bool
+    BatchPublisher::flush()
+    {
+        Lock    _lock(mx_);
+        return count_ == 0 || commit_( _lock );
+    }
+
+    //!> A failed commit is rolled back: the whole batch is lost, and said to be.
+    bool
+    BatchPublisher::commit_( Lock& lock )
+    {
+        bool        _ok(true);
+        try { sess_->commit(); }
+        catch (cms::CMSException&)
+        {
+            _ok = false;
+            try { sess_->rollback(); } catch (cms::CMSException&) {}
+        }
+        ended_.emplace_back( std::move(dones_), _ok );
+        dones_.clear();
+        count_ = bytes_ = 0;
+        deliver_( lock );
+        return _ok;
+    }
+
+    /**
+     * Whoever finds no delivery in progress delivers every batch ended
+     * so far, the others' included, in order. A completion may publish:
+     * a batch it ends waits its turn in ended_. One that throws is
+     * logged, and the rest go on (the timer thread must not see it).
+     */
+    void
+    BatchPublisher::deliver_( Lock& lock )
+    {
+        if ( delivering_ ) { return; }
+        delivering_ = true;
+        while ( !ended_.empty() )
+        {
+            auto    _batch(std::move(ended_.front()));
+            ended_.pop_front();
+            lock.unlock();
+            for ( auto& _done : _batch.first )
+            {
+                try { _done( _batch.second ); }
+                catch (std::exception& e) { LOG_STRM_ERROR(nullptr, "batch completion threw: " << e.what()); }
+                catch (...) { LOG_STRM_ERROR(nullptr, "batch completion threw"); }
+            }
+            lock.lock();
+        }
+        delivering_ = false;
+    }
+
+    //!> The time limit: a batch is committed when its first message is old enough.
+    void
+    BatchPublisher::run_()
+    {
+        Lock    _lock(mx_);
+        while ( !stopped_ )
+        {
+            if ( count_ == 0 )
+            {
+                armed_.wait( _lock );
+                continue;
+            }
+            auto    _due(first_ + std::chrono::milliseconds(limits_.millis_));
+            if ( Clock::now() >= _due ) { commit_( _lock ); }
+            else { armed_.wait_until( _lock, _due ); }
+        }
+    }
+
+} // namespace ams
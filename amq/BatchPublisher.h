@@ -0,0 +1,107 @@
+/** ======================================================================+
+ + Copyright @2020-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#pragma once
+
+#ifndef AMS_BATCHPUBLISHER_H
+#define AMS_BATCHPUBLISHER_H
+
+#include "AmqAgent.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+    /**
+     * @file BatchPublisher.h
+     * @brief Publishing in transactions: one broker round trip per batch.
+     */
+
+namespace ams
+{
+    /**
+     * @class BatchPublisher
+     * @brief Messages go out on a transacted session, and are committed
+     * together when a batch reaches count_ messages or bytes_ of text,
+     * or when its first message is millis_ old (0: no time limit).
+     * Thread-safe. Non-persistent traffic is also sent asynchronously
+     * (no wait for the broker even outside a commit).
+     * A completion is called once, after its batch has been committed
+     * (true) or rolled back (false), on a thread that ended a batch:
+     * batches are delivered in the order they ended, one at a time.
+     * An exception from a completion is logged, not passed on.
+     */
+    class BatchPublisher
+    {
+        using ConnScope = StartStop<ConnectionPtr>;
+        using Mutex     = std::mutex;
+        using Lock      = std::unique_lock<Mutex>;
+        using Clock     = std::chrono::steady_clock;
+    public:
+        using Completion  = std::function<void(bool)>;
+        using Completions = std::vector<Completion>;
+        using Ended       = std::deque<std::pair<Completions, bool>>; // with the outcome
+
+        struct Limits
+        {
+            std::size_t     count_{100};
+            std::size_t     bytes_{1 << 20};
+            long            millis_{50};
+
+            Limits& count( std::size_t count ) { count_ = count > 0 ? count : 1; return *this; }
+            Limits& bytes( std::size_t bytes ) { bytes_ = bytes; return *this; }
+            Limits& millis( long millis ) { millis_ = millis > 0 ? millis : 0; return *this; }
+        };
+
+        ~BatchPublisher() noexcept; // commits what is left
+
+        explicit
+        BatchPublisher(Credentials const& cred) : BatchPublisher(cred, Limits()) {}
+        BatchPublisher(Credentials const& cred, Limits const& limits, bool persistent = true);
+
+        explicit operator bool() const { return conn_ && sess_; }
+
+        // false if the send failed (done is not kept)
+        bool publish( EndPoint const& endpoint, std::string const& text, Completion done = Completion() );
+        bool flush();  // commit now; true if there was nothing to commit, or it was
+
+        // Rule of Five
+        BatchPublisher(BatchPublisher const&) = delete;
+        BatchPublisher& operator=( BatchPublisher const& ) = delete;
+
+    private: // Order alert! This is for safety in destructor sequence
+        Credentials     cred_;
+        ExceptionLogger logger_; // must outlive connection
+        ConnectionPtr   conn_;
+        SessionPtr      sess_;   // transacted
+        ConnScope       scope_;  // connection activation
+        SendMap         tgts_;   // publishers, by destination
+        Limits          limits_;
+        //
+        Mutex                   mx_;     // the session is not thread-safe
+        std::condition_variable armed_;  // a batch has begun, or we stop
+        Completions             dones_;  // of the current batch
+        Ended                   ended_;  // batches to deliver, in order
+        bool                    delivering_{false};
+        std::size_t             count_{0};
+        std::size_t             bytes_{0};
+        Clock::time_point       first_;  // of the current batch
+        bool                    stopped_{false};
+        std::thread             timer_;
+
+        bool commit_( Lock& lock ); // with mx_ held, released for the completions
+        void deliver_( Lock& lock );
+        void run_();
+    };
+
+} // namespace ams
+
+#endif // AMS_BATCHPUBLISHER_H
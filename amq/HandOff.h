@@ -0,0 +1,202 @@
+/** ======================================================================+
+ + Copyright @2020-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#pragma once
+
+#ifndef AMS_HANDOFF_H
+#define AMS_HANDOFF_H
+
+#include "BasicQueue.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+    /**
+     * @file HandOff.h
+     * @brief Passing message bodies to clients: directly, or through a
+     * queue to worker threads, away from the CMS session threads.
+     */
+
+namespace ams {
+
+    template<typename Client, typename Info, typename = void>
+    struct TakesView : std::false_type {};
+
+    template<typename Client, typename Info>
+    struct TakesView<Client, Info, std::void_t<decltype(std::declval<Client&>().on_message( std::declval<std::string_view>(), std::declval<Info const&>() ))>>
+    : std::true_type {};
+
+    //!> The body as the client takes it: see MessageHandler
+    template<typename Client, typename Info>
+    void deliver( Client& client, std::string&& body, Info const& info )
+    {
+        if constexpr ( TakesView<Client, Info>::value ) { client.on_message( std::string_view(body), info ); }
+        else { client.on_message( std::move(body), info ); }
+    }
+
+    /**
+     * @class HandOff
+     * @brief A bounded queue between the CMS session threads and a pool
+     * of workers that call the client. Each source (a listener's Info)
+     * is pinned to one worker, by hash, so its messages stay in order.
+     * put() blocks while capacity_ messages are waiting: a slow client
+     * holds a session thread up only once the queue is full.
+     * stop() delivers the messages still queued (with automatic
+     * acknowledgement they are acked already), or discards them; either
+     * way, no call to the client is made once it returns. The destructor
+     * delivers: a client that is torn down first must stop() before.
+     */
+    template<typename Client, typename Info = std::string, typename Hash = std::hash<Info>>
+    class HandOff
+    {
+        using Clock = std::chrono::steady_clock;
+        using Mutex = std::mutex;
+        using Lock  = std::unique_lock<Mutex>;
+
+        struct Item
+        {
+            std::string         body_;
+            Info                info_;
+            Clock::time_point   queued_;
+        };
+        using Queue = Utility::BasicQueue<Item>;
+
+        struct Lane
+        {
+            Queue           queue_;
+            std::thread     worker_;
+        };
+        using Lanes = std::vector<std::unique_ptr<Lane>>;
+
+    public:
+        struct Stats
+        {
+            std::size_t     depth_;      // waiting now
+            std::size_t     peak_;       // most ever waiting
+            std::size_t     delivered_;
+            std::size_t     blocked_;    // put()s that waited for room
+            double          meanWait_;   // us, queued to delivery
+            double          maxWait_;    // us
+        };
+
+        ~HandOff() noexcept { stop(); }
+
+        explicit
+        HandOff(Client& client, std::size_t workers = 1, std::size_t capacity = 10000)
+        : cp_(&client)
+        , capacity_(std::max( capacity, std::size_t(1) ))
+        {
+            for ( std::size_t _i(0); _i < std::max( workers, std::size_t(1) ); ++_i )
+            {
+                lanes_.emplace_back( std::make_unique<Lane>() );
+                Queue&  _queue(lanes_.back()->queue_);
+                lanes_.back()->worker_ = std::thread([this, &_queue]()
+                {
+                    auto    _run([this]( Item& item ) { run_( item ); });
+                    _queue.pump( _run );
+                    if ( discard_ ) { _queue.drain( [this]( Item& ) { drop_(); } ); }
+                    else { _queue.drain( _run ); } // what was left at stop()
+                });
+            }
+        }
+
+        //!> No more put()s; once the queued messages are delivered (or not), the workers are gone
+        void stop( bool deliver = true )
+        {
+            {
+                Lock    _lock(mx_);
+                if ( stopped_ ) { return; }
+                stopped_ = true;
+                discard_ = !deliver;
+            }
+            for ( auto& _lane : lanes_ ) { _lane->queue_.stop(); }
+            for ( auto& _lane : lanes_ ) { _lane->worker_.join(); }
+        }
+
+        std::size_t lane( Info const& info ) const { return Hash()( info ) % lanes_.size(); }
+
+        //!> false once stopped: the body is lost
+        bool put( std::size_t lane, std::string&& body, Info const& info )
+        {
+            {
+                Lock    _lock(mx_);
+                if ( depth_ >= capacity_ )
+                {
+                    ++blocked_;
+                    room_.wait( _lock, [this]() { return depth_ < capacity_; } );
+                }
+                peak_ = std::max( peak_, ++depth_ );
+            }
+            if ( lanes_[lane]->queue_.put( Item{std::move(body), info, Clock::now()} ) ) { return true; }
+            drop_();
+            return false;
+        }
+
+        Stats stats() const
+        {
+            Lock    _lock(mx_);
+            auto    _us([]( Clock::duration d ) { return std::chrono::duration<double, std::micro>(d).count(); });
+            return Stats{depth_, peak_, delivered_, blocked_
+                        , delivered_ ? _us( waited_ ) / delivered_ : 0.0
+                        , _us( maxWait_ )};
+        }
+
+        // Rule of Five
+        HandOff(HandOff const&) = delete;
+        HandOff& operator=( HandOff const& ) = delete;
+
+    private:
+        Client*                 cp_;
+        std::size_t             capacity_;
+        Mutex mutable           mx_;
+        std::condition_variable room_;
+        std::size_t             depth_{0};
+        std::size_t             peak_{0};
+        std::size_t             delivered_{0};
+        std::size_t             blocked_{0};
+        Clock::duration         waited_{};
+        Clock::duration         maxWait_{};
+        bool                    stopped_{false};
+        std::atomic<bool>       discard_{false}; // what is left at stop()
+        Lanes                   lanes_;  // last: the workers use the rest
+
+        void drop_()
+        {
+            {
+                Lock    _lock(mx_);
+                --depth_;
+            }
+            room_.notify_one();
+        }
+
+        void run_( Item& item )
+        {
+            auto    _waited(Clock::now() - item.queued_);
+            {
+                Lock    _lock(mx_);
+                --depth_;
+                ++delivered_;
+                waited_ += _waited;
+                maxWait_ = std::max( maxWait_, _waited );
+            }
+            room_.notify_one();
+            deliver( *cp_, std::move(item.body_), item.info_ );
+        }
+    };
+
+} // namespace ams
+
+#endif // AMS_HANDOFF_H
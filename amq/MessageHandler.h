@@ -9,10 +9,11 @@
 #define AMS_MSGLISTENER_H
 
 #include "AmqAPI.h"
+#include "HandOff.h"
 #include "Logging.h"
 
 #include <string>
-#include <vector>
+#include <utility>
 
     /**
      * @class MessageHandler
@@ -24,6 +25,16 @@
      * (The general idea being that each separate consumer will pass
      *  its own context-specific Info to identify message targets.)
      *
+     * The body is passed as one of:
+     *  - std::string_view, if the client takes one: valid for the call;
+     *  - std::string const&: no copy, the buffer is reused;
+     *  - std::string (or &&): the client takes the buffer over.
+     * BytesMessage bodies are read into a per-listener buffer (a
+     * listener is called by one session at a time), which keeps its
+     * capacity from one message to the next unless it is taken.
+     * Given a HandOff, the body is queued instead, and the client is
+     * called on one of its workers.
+     *
      * May need modification to adapt to logging system employed.
      */
 namespace ams {
@@ -40,10 +51,14 @@ namespace ams {
     : public cms::MessageListener
     {
     public:
+        using HandOffType = HandOff<Client, Info>;
+
         ~MessageHandler() noexcept = default;
-        MessageHandler(Client& client, Info const& info = Info())
+        MessageHandler(Client& client, Info const& info = Info(), HandOffType* handoff = nullptr)
         : cp_(&client)
         , info_(info)
+        , hop_(handoff)
+        , lane_(handoff ? handoff->lane( info ) : 0)
         {}
 
         void onMessage( cms::Message const* msg ) override
@@ -52,7 +67,7 @@ namespace ams {
             if ( _tptr )
             {
                 //LOG_STRM_DEBUG(nullptr, "TextMessage [" << ToPrint::convert( info_ ) << "] received.");
-                cp_->on_message( _tptr->getText(), info_ );
+                deliver_( _tptr->getText() );
                 return;
             }
             // fallback for ActiveMQ "smart" handling of stomp messages
@@ -60,10 +75,10 @@ namespace ams {
             if ( _bptr )
             {
                 LOG_STRM_DEBUG(nullptr, "BytesMessage [" << ToPrint::convert( info_ ) << "] received.");
-                int                         _len(_bptr->getBodyLength());
-                std::vector<unsigned char>  _vec(_len, '\0');
-                _bptr->readBytes( _vec );                
-                cp_->on_message( std::string(reinterpret_cast<char*>(_vec.data()), _len), info_ );
+                int     _len(_bptr->getBodyLength());
+                buf_.resize( _len );
+                if ( _len > 0 ) { _bptr->readBytes( reinterpret_cast<unsigned char*>(&buf_[0]), _len ); }
+                deliver_( std::move(buf_) );
                 return;
             }
             // types not handled
@@ -86,7 +101,15 @@ namespace ams {
     private:
         Client*     cp_;
         Info        info_;
+        std::string buf_;   // BytesMessage bodies
+        HandOffType* hop_;  // not owned; none: the client is called here
+        std::size_t lane_;
         //
+        void deliver_( std::string&& body )
+        {
+            if ( hop_ ) { hop_->put( lane_, std::move(body), info_ ); }
+            else { deliver( *cp_, std::move(body), info_ ); }
+        }
     };
 
 } // namespace ams
@@ -8,12 +8,21 @@
 #include <iostream>
 #include <vector>
 #include <memory>
+#include <type_traits>
 
     /**
      * @class MessageReceiver
      * Implementation of a message receiver using MessageHandler.
      * This class may be used as is, or as a mixin superclass
      * that will delegate the on_message(...) call. 
+     * With more than one session, on_message(...) may be called
+     * concurrently (for different subscriptions).
+     * With workers, messages are handed off to that many threads, so
+     * that on_message(...) does not hold up the sessions; each
+     * subscription stays on one worker, in order.
+     * A CLIENT calls stop() from its own destructor, so that what is
+     * still queued reaches it while it is whole. If it does not, those
+     * messages are discarded at our destruction instead.
      */
     template<typename CLIENT = void>
     class MessageReceiver
@@ -21,17 +30,17 @@
         using Topic     = std::string;
         using Listener  = ams::MessageHandler<MessageReceiver>;
         using Listeners = std::vector<std::unique_ptr<Listener>>;
+        using HandOff   = typename Listener::HandOffType;
     public:
 
         ~MessageReceiver()
         {
-            if ( release_ ) { std::cerr << "Releasing subscriptions" << std::endl; }
-            for ( auto& _l : topics_ ) { agent_.unsubscribe( _l->get_info(), release_ ); }
-            for ( auto& _l : queues_ ) { agent_.unsubscribe( _l->get_info(), release_ ); }
+            stop( std::is_void<CLIENT>::value ); // a CLIENT not stopped by now is gone: no deliveries
         }
 
-        MessageReceiver(bool release = false)
-        : agent_(ams::Credentials())
+        MessageReceiver(bool release = false, std::size_t sessions = 1, std::size_t workers = 0)
+        : handoff_(workers > 0 ? std::make_unique<HandOff>(*this, workers) : nullptr)
+        , agent_(ams::Credentials(), sessions)
         , release_(release)
         {}
         // Rule of Five: move only
@@ -45,12 +54,12 @@
         {
             if ( isTopic )
             {
-                topics_.push_back( std::make_unique<Listener>(*this, dest) );
+                topics_.push_back( std::make_unique<Listener>(*this, dest, handoff_.get()) );
                 agent_.subscribe( {dest, !isTopic}, topics_.back().get() );
             }
             else
             {
-                queues_.push_back( std::make_unique<Listener>(*this, dest) );
+                queues_.push_back( std::make_unique<Listener>(*this, dest, handoff_.get()) );
                 agent_.subscribe( {dest, !isTopic}, queues_.back().get() );
             }
         }
@@ -64,6 +73,20 @@
             agent_.unsubscribe( {dest, !isTopic} );
         }
 
+        HandOff const* handoff() const { return handoff_.get(); } // for its stats()
+
+        //!> Unsubscribes all, then delivers (or discards) what the workers still have. Once only.
+        void
+        stop( bool deliver = true )
+        {
+            if ( release_ && !(topics_.empty() && queues_.empty()) ) { std::cerr << "Releasing subscriptions" << std::endl; }
+            for ( auto& _l : topics_ ) { agent_.unsubscribe( _l->get_info(), release_ ); }
+            for ( auto& _l : queues_ ) { agent_.unsubscribe( _l->get_info(), release_ ); }
+            topics_.clear();
+            queues_.clear();
+            if ( handoff_ ) { handoff_->stop( deliver ); }
+        }
+
         template<typename X = CLIENT>
         typename std::enable_if<std::is_void<X>::value, void>::type 
         on_message( std::string const& msg, std::string const& info )
@@ -80,6 +103,7 @@
         }
 
     private:
+        std::unique_ptr<HandOff>    handoff_; // outlives the consumers
         ams::AmqAgent   agent_;
         Listeners       topics_;
         Listeners       queues_;
@@ -6,6 +6,7 @@
 #include "MessageReceiver.h"
 #include "SigWait.h"
 #include <iostream>
+#include <cstdlib>
 #include <unistd.h> // getopt
 
     /**
@@ -17,9 +18,9 @@ class MyClient
 {
 public:
 
-    ~MyClient() = default;
-    MyClient(bool release = false)
-    : MessageReceiver<MyClient>(release)
+    ~MyClient() { stop(); } // while on_message() can still be called
+    MyClient(bool release = false, std::size_t sessions = 1, std::size_t workers = 0)
+    : MessageReceiver<MyClient>(release, sessions, workers)
     {}
     
     void on_message( std::string const& msg, std::string const& )
@@ -45,16 +46,18 @@ public:
     };
 
     int
-    process_args( int ac, char* av[], bool& isT, bool& rel )
+    process_args( int ac, char* av[], bool& isT, bool& rel, std::size_t& sess, std::size_t& work )
     {
         int             _opt;
         isT = true; // set a default
-        while ( (_opt = ::getopt( ac, av, "qrt" )) != -1 )
+        while ( (_opt = ::getopt( ac, av, "qrtp:w:" )) != -1 )
         switch ( _opt )
         {
         case 'q': isT  = false; break;
         case 'r': rel  = true; break;
         case 't': isT  = true; break;
+        case 'p': sess = std::strtoul( optarg, nullptr, 10 ); break;
+        case 'w': work = std::strtoul( optarg, nullptr, 10 ); break;
         default: break;
         }
         //
@@ -65,16 +68,25 @@ public:
     {
         bool                _isTopic{false};
         bool                _release{false};
-        int                 _start{process_args( ac, av, _isTopic, _release)};
+        std::size_t         _sessions{1}; // -p: consumer sessions in parallel
+        std::size_t         _workers{0};  // -w: hand-off worker threads
+        int                 _start{process_args( ac, av, _isTopic, _release, _sessions, _workers )};
         if ( ac <= _start ) { return on_error( "Not enough arguments" ); }
         //
         Utility::SigWait::install_handlers();
 #ifdef DEFAULT_IMPL
-        MessageReceiver     _client{_release};
+        MessageReceiver     _client{_release, _sessions, _workers};
 #else
-        MyClient            _client{_release};
+        MyClient            _client{_release, _sessions, _workers};
 #endif
         for ( ; _start < ac; ++_start ) { _client.subscribe( av[_start], _isTopic ); }
         Utility::SigWait(true).wait( ErrnoPolicy() );
+        if ( auto _hop = _client.handoff() )
+        {
+            auto    _stats(_hop->stats());
+            std::cerr << "Delivered " << _stats.delivered_ << ", queued at most " << _stats.peak_
+                      << ", blocked " << _stats.blocked_ << ", wait us mean " << _stats.meanWait_
+                      << " max " << _stats.maxWait_ << std::endl;
+        }
         return 0;
     }
@@ -0,0 +1,201 @@
+/** ======================================================================+
+ + Copyright @2020-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#include "AmqAgent.h"
+#include "BatchPublisher.h"
+#include "MessageHandler.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+
+    /**
+     * The cost of the wrapper, per publish and per delivery, against the
+     * in-process fake of CMS (FakeCms.h): what is left is AmqAPI.h,
+     * AmqAgent, MessageHandler and the client, plus one copy of each
+     * body (which CMS makes too). Deliveries are synchronous, so a
+     * publish with subscribers includes their callbacks.
+     * Build with: make OPT=-O2
+     */
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::size_t                 count_{200000};
+        std::vector<std::size_t>    sizes_{64, 1024, 16384};
+        std::vector<std::size_t>    subs_{0, 1, 4};
+    };
+
+    std::vector<std::size_t>
+    parse_list( char const* arg )
+    {
+        std::vector<std::size_t>    _list;
+        std::istringstream          _iss(arg);
+        std::string                 _item;
+        while ( std::getline( _iss, _item, ',' ) ) { _list.push_back( std::strtoul( _item.c_str(), nullptr, 10 ) ); }
+        return _list;
+    }
+
+    double
+    ns_per( Clock::time_point start, std::size_t count )
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+    }
+
+    // the three ways a client can take a body
+    struct ViewClient
+    {
+        std::size_t bytes_{0};
+        void on_message( std::string_view body, std::string const& ) { bytes_ += body.size(); }
+    };
+
+    struct CRefClient
+    {
+        std::size_t bytes_{0};
+        void on_message( std::string const& body, std::string const& ) { bytes_ += body.size(); }
+    };
+
+    struct OwnClient
+    {
+        std::size_t bytes_{0};
+        std::string kept_;
+        void on_message( std::string body, std::string const& ) { bytes_ += body.size(); kept_ = std::move(body); }
+    };
+
+    //!> A subscriber: an agent of its own, as a separate process would have
+    template<typename Client>
+    struct Subscriber
+    {
+        using Listener = ams::MessageHandler<Client>;
+
+        Client          client_;
+        ams::AmqAgent   agent_{ams::Credentials()};
+        Listener        listener_;
+        ams::EndPoint   source_;
+
+        ~Subscriber() { agent_.unsubscribe( source_ ); }
+        Subscriber(ams::EndPoint const& source, typename Listener::HandOffType* handoff = nullptr)
+        : listener_(client_, source.dest_, handoff)
+        , source_(source)
+        {
+            agent_.subscribe( source_, &listener_ );
+        }
+    };
+
+    template<typename Client>
+    double
+    publish( Options const& options, std::size_t size, std::size_t subs )
+    {
+        ams::EndPoint                                       _dest{"bench.publish"};
+        std::vector<std::unique_ptr<Subscriber<Client>>>    _subs;
+        for ( std::size_t _i(0); _i < subs; ++_i ) { _subs.emplace_back( std::make_unique<Subscriber<Client>>(_dest) ); }
+
+        ams::AmqAgent   _agent{ams::Credentials()};
+        std::string     _body(size, 'x');
+        auto            _start(Clock::now());
+        for ( std::size_t _i(0); _i < options.count_; ++_i ) { _agent.publish( _dest, _body ); }
+        return ns_per( _start, options.count_ );
+    }
+
+    double
+    batched( Options const& options, std::size_t size )
+    {
+        ams::EndPoint       _dest{"bench.batched"};
+        ams::BatchPublisher _batch(ams::Credentials(), ams::BatchPublisher::Limits().millis( 1000 ));
+        std::string         _body(size, 'x');
+        auto                _start(Clock::now());
+        for ( std::size_t _i(0); _i < options.count_; ++_i ) { _batch.publish( _dest, _body ); }
+        _batch.flush();
+        return ns_per( _start, options.count_ );
+    }
+
+    //!> Four subscriptions over a pool of workers: publish, then wait for the workers to catch up
+    void
+    handed_off( Options const& options, std::size_t size, std::size_t workers )
+    {
+        using HandOff = ams::HandOff<ViewClient>;
+
+        ViewClient                                          _client;
+        auto                                                _handoff(std::make_unique<HandOff>(_client, workers, 1000));
+        std::vector<std::unique_ptr<Subscriber<ViewClient>>> _subs;
+        for ( int _i(0); _i < 4; ++_i ) { _subs.emplace_back( std::make_unique<Subscriber<ViewClient>>(ams::EndPoint{"bench.handoff." + std::to_string( _i )}, _handoff.get()) ); }
+
+        ams::AmqAgent   _agent{ams::Credentials()};
+        std::string     _body(size, 'x');
+        auto            _start(Clock::now());
+        for ( std::size_t _i(0); _i < options.count_; ++_i ) { _agent.publish( _subs[_i % 4]->source_, _body ); }
+        auto            _stats(_handoff->stats());
+        _handoff.reset(); // drains
+        double          _ns(ns_per( _start, options.count_ ));
+
+        std::cout << std::setw(7) << size << std::setw(8) << workers
+                  << std::setw(10) << _ns
+                  << std::setw(8) << _stats.peak_ << std::setw(10) << _stats.blocked_
+                  << std::setw(12) << _stats.meanWait_ << std::setw(12) << _stats.maxWait_ << std::endl;
+    }
+}
+
+    int main( int ac, char* av[] )
+    {
+        Options     _options;
+        bool        _bytes(false);
+        int         _opt;
+        while ( (_opt = ::getopt( ac, av, "bn:s:c:" )) != -1 )
+        {
+            switch ( _opt )
+            {
+            case 'b': _bytes = true; break;
+            case 'n': _options.count_ = std::strtoul( optarg, nullptr, 10 ); break;
+            case 's': _options.sizes_ = parse_list( optarg ); break;
+            case 'c': _options.subs_  = parse_list( optarg ); break;
+            default:
+                std::cerr << "Usage: " << av[0] << " [-b] [-n <messages>] [-s <sizes>] [-c <subscribers>]\n"
+                          << "  -b: deliver BytesMessages; lists are comma separated" << std::endl;
+                return 1;
+            }
+        }
+        if ( _options.count_ == 0 || _options.sizes_.empty() || _options.subs_.empty() )
+        {
+            std::cerr << av[0] << ": nothing to do" << std::endl;
+            return 1;
+        }
+        fake::Broker::instance().bytes( _bytes );
+        std::cout << std::fixed << std::setprecision(1)
+                  << "ns per publish, " << (_bytes ? "BytesMessage" : "TextMessage") << " deliveries included\n"
+                  << "   size    subs      view      cref       own" << std::endl;
+        for ( std::size_t _size : _options.sizes_ )
+        {
+            for ( std::size_t _subs : _options.subs_ )
+            {
+                std::cout << std::setw(7) << _size << std::setw(8) << _subs
+                          << std::setw(10) << publish<ViewClient>( _options, _size, _subs )
+                          << std::setw(10) << publish<CRefClient>( _options, _size, _subs )
+                          << std::setw(10) << publish<OwnClient>( _options, _size, _subs ) << std::endl;
+            }
+        }
+
+        std::cout << "\nns per publish, batched (no subscribers)\n"
+                  << "   size   batch" << std::endl;
+        for ( std::size_t _size : _options.sizes_ ) { std::cout << std::setw(7) << _size << std::setw(8) << batched( _options, _size ) << std::endl; }
+
+        std::cout << "\nns per publish, handed off to workers (4 subscriptions)\n"
+                  << "   size workers   publish    peak   blocked   wait mean    wait max (us)" << std::endl;
+        for ( std::size_t _size : _options.sizes_ )
+        {
+            for ( std::size_t _workers : {1, 2} ) { handed_off( _options, _size, _workers ); }
+        }
+        return 0;
+    }
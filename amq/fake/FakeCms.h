@@ -0,0 +1,473 @@
+/** ======================================================================+
+ + Copyright @2020-2026 Arjun Ray
+ + Released under MIT License
+ + see https://mit-license.org
+ +========================================================================*/
+#pragma once
+
+#ifndef AMS_FAKECMS_H
+#define AMS_FAKECMS_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+    /**
+     * @file FakeCms.h
+     * @brief An in-process stand-in for the parts of ActiveMQ-CPP that
+     * AmqAPI.h wraps: the headers under cms/ and activemq/ here all
+     * include this one, so the wrapper compiles unchanged against it
+     * (with -I pointing here instead of at ActiveMQ-CPP).
+     *
+     * The CMS interfaces are abstract, as they are in CMS, so calls
+     * through the wrapper cost what they would. Behind them, one broker
+     * per process routes messages in memory:
+     *  - a send copies the body, as CMS does;
+     *  - delivery is synchronous, on the sending thread (or the one
+     *    that commits), one message at a time over the whole process,
+     *    so a listener is never called concurrently, as with a session;
+     *  - topics go to every consumer, queues round-robin to consumers,
+     *    and are held while there are none;
+     *  - consumers without listeners keep messages for receiveNoWait();
+     *  - transacted sessions hold sends until commit(); acknowledgement
+     *    modes are otherwise ignored, as is start()/stop().
+     * Broker::instance().bytes( true ) delivers BytesMessages, as ActiveMQ
+     * does for STOMP traffic without a content-length.
+     */
+
+namespace cms
+{
+    class CMSException : public std::runtime_error
+    {
+    public:
+        explicit CMSException(std::string const& what = "CMSException") : std::runtime_error(what) {}
+    };
+
+    class DeliveryMode
+    {
+    public:
+        enum DELIVERY_MODE { PERSISTENT = 0, NON_PERSISTENT = 1 };
+    };
+
+    class Destination
+    {
+    public:
+        enum DestinationType { TOPIC, QUEUE, TEMPORARY_TOPIC, TEMPORARY_QUEUE };
+        virtual ~Destination() = default;
+        virtual DestinationType getDestinationType() const = 0;
+    };
+
+    class Message
+    {
+    public:
+        virtual ~Message() = default;
+    };
+
+    class TextMessage : public Message
+    {
+    public:
+        virtual std::string getText() const = 0;
+        virtual void setText( std::string const& text ) = 0;
+        virtual void clearBody() = 0;
+    };
+
+    class BytesMessage : public Message
+    {
+    public:
+        virtual int getBodyLength() const = 0;
+        virtual int readBytes( unsigned char* buffer, int length ) const = 0;
+        virtual void readBytes( std::vector<unsigned char>& buffer ) const = 0;
+    };
+
+    class MapMessage : public Message {};
+    class StreamMessage : public Message {};
+
+    class MessageListener
+    {
+    public:
+        virtual ~MessageListener() = default;
+        virtual void onMessage( Message const* message ) = 0;
+    };
+
+    class ExceptionListener
+    {
+    public:
+        virtual ~ExceptionListener() = default;
+        virtual void onException( CMSException const& ex ) = 0;
+    };
+
+    class MessageConsumer
+    {
+    public:
+        virtual ~MessageConsumer() = default;
+        virtual void setMessageListener( MessageListener* listener ) = 0;
+        virtual MessageListener* getMessageListener() const = 0;
+        virtual Message* receiveNoWait() = 0;
+        virtual void close() = 0;
+    };
+
+    class MessageProducer
+    {
+    public:
+        virtual ~MessageProducer() = default;
+        virtual void send( Message* message ) = 0;
+        virtual void send( Destination const* destination, Message* message ) = 0;
+        virtual void setDeliveryMode( int mode ) = 0;
+        virtual int getDeliveryMode() const = 0;
+        virtual void close() = 0;
+    };
+
+    class Session
+    {
+    public:
+        enum AcknowledgeMode { AUTO_ACKNOWLEDGE, DUPS_OK_ACKNOWLEDGE, CLIENT_ACKNOWLEDGE, SESSION_TRANSACTED, INDIVIDUAL_ACKNOWLEDGE };
+        virtual ~Session() = default;
+        virtual Destination* createTopic( std::string const& name ) = 0;
+        virtual Destination* createQueue( std::string const& name ) = 0;
+        virtual MessageConsumer* createConsumer( Destination const* destination ) = 0;
+        virtual MessageProducer* createProducer( Destination const* destination = nullptr ) = 0;
+        virtual TextMessage* createTextMessage( std::string const& text ) = 0;
+        virtual void commit() = 0;
+        virtual void rollback() = 0;
+        virtual void close() = 0;
+    };
+} // namespace cms
+
+namespace activemq
+{
+namespace library
+{
+    struct ActiveMQCPP
+    {
+        static void initializeLibrary() {}
+        static void shutdownLibrary() {}
+    };
+} // namespace library
+
+namespace exceptions
+{
+    class ActiveMQException : public cms::CMSException
+    {
+    public:
+        using cms::CMSException::CMSException;
+    };
+} // namespace exceptions
+
+namespace transport
+{
+    class TransportListener
+    {
+    public:
+        virtual ~TransportListener() = default;
+        virtual void transportInterrupted() = 0;
+        virtual void transportResumed() = 0;
+    };
+
+    class DefaultTransportListener : public TransportListener
+    {
+    public:
+        void transportInterrupted() override {}
+        void transportResumed() override {}
+    };
+} // namespace transport
+
+namespace commands
+{
+    class ActiveMQDestination : public cms::Destination
+    {
+    public:
+        ActiveMQDestination(std::string const& name, DestinationType type) : name_(name), type_(type) {}
+        DestinationType getDestinationType() const override { return type_; }
+        std::string const& getPhysicalName() const { return name_; }
+        bool isTopic() const { return type_ == TOPIC; }
+    private:
+        std::string     name_;
+        DestinationType type_;
+    };
+
+    struct ActiveMQTopic : ActiveMQDestination
+    {
+        explicit ActiveMQTopic(std::string const& name) : ActiveMQDestination(name, TOPIC) {}
+    };
+
+    struct ActiveMQQueue : ActiveMQDestination
+    {
+        explicit ActiveMQQueue(std::string const& name) : ActiveMQDestination(name, QUEUE) {}
+    };
+} // namespace commands
+} // namespace activemq
+
+namespace activemq { namespace core { class ActiveMQSession; } }
+
+namespace fake
+{
+    using activemq::commands::ActiveMQDestination;
+
+    class TextMessage : public cms::TextMessage
+    {
+    public:
+        explicit TextMessage(std::string const& text = std::string()) : text_(text) {}
+        std::string getText() const override { return text_; }
+        void setText( std::string const& text ) override { text_ = text; }
+        void clearBody() override { text_.clear(); }
+        std::string const& text() const { return text_; }
+    private:
+        std::string text_;
+    };
+
+    class BytesMessage : public cms::BytesMessage
+    {
+    public:
+        explicit BytesMessage(std::string const& body) : body_(body) {}
+        int getBodyLength() const override { return int(body_.size()); }
+        int readBytes( unsigned char* buffer, int length ) const override
+        {
+            int     _len(std::min( length, getBodyLength() ));
+            std::memcpy( buffer, body_.data(), _len );
+            return _len;
+        }
+        void readBytes( std::vector<unsigned char>& buffer ) const override { readBytes( buffer.data(), int(buffer.size()) ); }
+    private:
+        std::string const&  body_;
+    };
+
+    class Consumer;
+
+    /**
+     * @class Broker
+     * @brief The routing behind the fake: see the file comment.
+     */
+    class Broker
+    {
+        using Mutex = std::recursive_mutex; // listeners may publish
+        using Guard = std::lock_guard<Mutex>;
+        struct Route
+        {
+            std::vector<Consumer*>  consumers_;
+            std::size_t             next_{0};    // queues: round robin
+            std::deque<std::string> held_;       // queues: no consumers
+        };
+        using Routes = std::unordered_map<std::string, Route>;
+    public:
+        static Broker& instance() { static Broker _broker; return _broker; }
+
+        Broker& bytes( bool bytes ) { bytes_ = bytes; return *this; }
+
+        void route( ActiveMQDestination const& dest, std::string const& body );
+        void attach( ActiveMQDestination const& dest, Consumer* consumer );
+        void detach( ActiveMQDestination const& dest, Consumer* consumer );
+        bool take( ActiveMQDestination const& dest, std::string& body ); // a held queue message
+        void destroy( ActiveMQDestination const& dest )
+        {
+            Guard   _guard(mx_);
+            auto    _itr(routes( dest ).find( dest.getPhysicalName() ));
+            if ( _itr != routes( dest ).end() && _itr->second.consumers_.empty() ) { routes( dest ).erase( _itr ); }
+        }
+
+    private:
+        Mutex   mx_;
+        Routes  topics_;
+        Routes  queues_;
+        bool    bytes_{false};
+
+        Routes& routes( ActiveMQDestination const& dest ) { return dest.isTopic() ? topics_ : queues_; }
+    };
+
+    class Consumer : public cms::MessageConsumer
+    {
+    public:
+        ~Consumer() override { close(); }
+        explicit Consumer(ActiveMQDestination const& dest)
+        : dest_(dest)
+        {
+            Broker::instance().attach( dest_, this );
+        }
+
+        void setMessageListener( cms::MessageListener* listener ) override { listener_ = listener; }
+        cms::MessageListener* getMessageListener() const override { return listener_; }
+
+        cms::Message* receiveNoWait() override
+        {
+            std::string     _body;
+            if ( !inbox_.empty() )
+            {
+                _body = std::move(inbox_.front());
+                inbox_.pop_front();
+            }
+            else if ( !Broker::instance().take( dest_, _body ) ) { return nullptr; }
+            return new TextMessage(_body);
+        }
+
+        void close() override
+        {
+            if ( open_ ) { Broker::instance().detach( dest_, this ); }
+            open_ = false;
+        }
+
+        //!> From the broker, with its lock held
+        void deliver( cms::Message const& message, std::string const& body )
+        {
+            if ( listener_ ) { listener_->onMessage( &message ); }
+            else { inbox_.push_back( body ); }
+        }
+
+    private:
+        ActiveMQDestination     dest_;
+        cms::MessageListener*   listener_{nullptr};
+        std::deque<std::string> inbox_;
+        bool                    open_{true};
+    };
+
+    inline void
+    Broker::route( ActiveMQDestination const& dest, std::string const& body )
+    {
+        Guard           _guard(mx_);
+        Route&          _route(routes( dest )[dest.getPhysicalName()]);
+        TextMessage     _text(bytes_ ? std::string() : body);
+        BytesMessage    _bytes(body);
+        cms::Message&   _message(bytes_ ? static_cast<cms::Message&>(_bytes) : _text);
+        if ( dest.isTopic() )
+        {
+            for ( auto _consumer : _route.consumers_ ) { _consumer->deliver( _message, body ); }
+        }
+        else if ( _route.consumers_.empty() ) { _route.held_.push_back( body ); }
+        else { _route.consumers_[_route.next_++ % _route.consumers_.size()]->deliver( _message, body ); }
+    }
+
+    inline void
+    Broker::attach( ActiveMQDestination const& dest, Consumer* consumer )
+    {
+        Guard   _guard(mx_);
+        routes( dest )[dest.getPhysicalName()].consumers_.push_back( consumer );
+    }
+
+    inline void
+    Broker::detach( ActiveMQDestination const& dest, Consumer* consumer )
+    {
+        Guard   _guard(mx_);
+        auto&   _consumers(routes( dest )[dest.getPhysicalName()].consumers_);
+        _consumers.erase( std::remove( _consumers.begin(), _consumers.end(), consumer ), _consumers.end() );
+    }
+
+    inline bool
+    Broker::take( ActiveMQDestination const& dest, std::string& body )
+    {
+        Guard   _guard(mx_);
+        if ( dest.isTopic() ) { return false; }
+        auto&   _held(queues_[dest.getPhysicalName()].held_);
+        if ( _held.empty() ) { return false; }
+        body = std::move(_held.front());
+        _held.pop_front();
+        return true;
+    }
+
+    class Producer : public cms::MessageProducer
+    {
+    public:
+        Producer(activemq::core::ActiveMQSession& session, cms::Destination const* dest)
+        : session_(session)
+        , dest_(static_cast<ActiveMQDestination const*>(dest))
+        {}
+
+        void send( cms::Message* message ) override
+        {
+            if ( !dest_ ) { throw cms::CMSException("no destination bound"); }
+            send( dest_, message );
+        }
+        void send( cms::Destination const* dest, cms::Message* message ) override;
+        void setDeliveryMode( int mode ) override { mode_ = mode; }
+        int getDeliveryMode() const override { return mode_; }
+        void close() override {}
+
+    private:
+        activemq::core::ActiveMQSession&    session_;
+        ActiveMQDestination const*          dest_;  // owned by the caller
+        int                         mode_{cms::DeliveryMode::PERSISTENT};
+    };
+} // namespace fake
+
+namespace activemq
+{
+namespace core
+{
+    class ActiveMQSession : public cms::Session
+    {
+        using Pending = std::vector<std::pair<commands::ActiveMQDestination, std::string>>;
+    public:
+        explicit ActiveMQSession(AcknowledgeMode mode) : mode_(mode) {}
+
+        cms::Destination* createTopic( std::string const& name ) override { return new commands::ActiveMQTopic(name); }
+        cms::Destination* createQueue( std::string const& name ) override { return new commands::ActiveMQQueue(name); }
+        cms::MessageConsumer* createConsumer( cms::Destination const* dest ) override
+        {
+            return new fake::Consumer(*static_cast<commands::ActiveMQDestination const*>(dest));
+        }
+        cms::MessageProducer* createProducer( cms::Destination const* dest ) override { return new fake::Producer(*this, dest); }
+        cms::TextMessage* createTextMessage( std::string const& text ) override { return new fake::TextMessage(text); }
+
+        void commit() override
+        {
+            if ( mode_ != SESSION_TRANSACTED ) { throw cms::CMSException("not transacted"); }
+            Pending     _pending;
+            _pending.swap( pending_ );
+            for ( auto& _item : _pending ) { fake::Broker::instance().route( _item.first, _item.second ); }
+        }
+        void rollback() override
+        {
+            if ( mode_ != SESSION_TRANSACTED ) { throw cms::CMSException("not transacted"); }
+            pending_.clear();
+        }
+        void close() override { pending_.clear(); }
+
+        //!> The body is copied here, as CMS copies a message sent
+        void send( commands::ActiveMQDestination const& dest, std::string const& body )
+        {
+            if ( mode_ == SESSION_TRANSACTED ) { pending_.emplace_back( dest, body ); }
+            else { fake::Broker::instance().route( dest, body ); }
+        }
+
+    private:
+        AcknowledgeMode mode_;
+        Pending         pending_;
+    };
+
+    class ActiveMQConnection
+    {
+    public:
+        void start() {}
+        void stop() {}
+        void close() {}
+        ActiveMQSession* createSession( cms::Session::AcknowledgeMode mode ) { return new ActiveMQSession(mode); }
+        void addTransportListener( transport::TransportListener* ) {}
+        void setExceptionListener( cms::ExceptionListener* ) {}
+        void setUseAsyncSend( bool ) {}
+        void destroyDestination( commands::ActiveMQDestination const* dest ) { fake::Broker::instance().destroy( *dest ); }
+    };
+
+    class ActiveMQConnectionFactory
+    {
+    public:
+        explicit ActiveMQConnectionFactory(std::string const&) {}
+        ActiveMQConnection* createConnection() { return new ActiveMQConnection(); }
+    };
+} // namespace core
+} // namespace activemq
+
+namespace fake
+{
+    inline void
+    Producer::send( cms::Destination const* dest, cms::Message* message )
+    {
+        auto    _text(dynamic_cast<TextMessage const*>(message));
+        if ( !_text ) { throw cms::CMSException("only TextMessages are faked"); }
+        session_.send( *static_cast<ActiveMQDestination const*>(dest), _text->text() );
+    }
+} // namespace fake
+
+#endif // AMS_FAKECMS_H
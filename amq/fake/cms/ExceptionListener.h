@@ -0,0 +1,2 @@
+// Include seam: see FakeCms.h
+#include "../FakeCms.h"
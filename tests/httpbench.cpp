@@ -0,0 +1,219 @@
+#include "HttpAgent.h"
+#include "HttpAsyncAgent.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+
+    /**
+     * httpbench: request latency (p50/p99/p99.9, us) and throughput of
+     * HttpAgent against a server, by default httpstub on its port:
+     *   sync  - one SimpleAgent per thread, a GET at a time
+     *   spec  - the same, through one prepared RequestSpec per thread
+     *   async - one AsyncAgent keeping <concurrency> GETs in flight
+     * Each size is asked for with ?size=N (which httpstub honours).
+     * Usage: httpbench [-u url] [-n requests] [-s sizes] [-c concurrencies]
+     */
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::string                 url_{"http://127.0.0.1:18080/"};
+        std::size_t                 count_{20000};
+        std::vector<std::size_t>    sizes_{64, 4096, 65536};
+        std::vector<std::size_t>    conc_{1, 4, 16};
+    };
+
+    struct Result
+    {
+        std::vector<long>   micros_;  // per request
+        std::size_t         errors_{0};
+        double              secs_{0};
+    };
+
+    std::vector<std::size_t>
+    parse_list( char const* arg )
+    {
+        std::vector<std::size_t>    _list;
+        std::istringstream          _iss(arg);
+        std::string                 _item;
+        while ( std::getline( _iss, _item, ',' ) ) { _list.push_back( std::strtoul( _item.c_str(), nullptr, 10 ) ); }
+        return _list;
+    }
+
+    long
+    micros_since( Clock::time_point start )
+    {
+        return long(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    }
+
+    //!> n requests over c threads, each making its share with a fresh agent of its own
+    template<typename Run>
+    Result
+    threaded( std::size_t count, std::size_t conc, Run run )
+    {
+        std::vector<Result>         _parts(conc);
+        std::vector<std::thread>    _threads;
+        auto                        _start(Clock::now());
+        for ( std::size_t _t(0); _t < conc; ++_t )
+        {
+            std::size_t _share(count / conc + (_t < count % conc ? 1 : 0));
+            _threads.emplace_back( [&, _t, _share]() { run( _share, _parts[_t] ); } );
+        }
+        for ( auto& _thread : _threads ) { _thread.join(); }
+
+        Result  _all;
+        _all.secs_ = std::chrono::duration<double>(Clock::now() - _start).count();
+        for ( auto& _part : _parts )
+        {
+            _all.micros_.insert( _all.micros_.end(), _part.micros_.begin(), _part.micros_.end() );
+            _all.errors_ += _part.errors_;
+        }
+        return _all;
+    }
+
+    Result
+    sync( std::string const& url, std::size_t count, std::size_t conc )
+    {
+        return threaded( count, conc, [&url]( std::size_t share, Result& result )
+        {
+            Utility::http::SimpleAgent  _agent;
+            result.micros_.reserve( share );
+            for ( std::size_t _i(0); _i < share; ++_i )
+            {
+                auto    _start(Clock::now());
+                bool    _ok(_agent( url ) && _agent.get_code() == 200);
+                result.micros_.push_back( micros_since( _start ) );
+                if ( !_ok ) { ++result.errors_; }
+            }
+        } );
+    }
+
+    Result
+    spec( std::string const& url, std::size_t count, std::size_t conc )
+    {
+        return threaded( count, conc, [&url]( std::size_t share, Result& result )
+        {
+            Utility::http::SimpleAgent  _agent;
+            Utility::http::RequestSpec  _spec(url);
+            result.micros_.reserve( share );
+            for ( std::size_t _i(0); _i < share; ++_i )
+            {
+                auto    _start(Clock::now());
+                bool    _ok(_agent( _spec ) && _agent.get_code() == 200);
+                result.micros_.push_back( micros_since( _start ) );
+                if ( !_ok ) { ++result.errors_; }
+            }
+        } );
+    }
+
+    //!> Every completion (on the agent's thread) submits the next request, until count
+    Result
+    async( std::string const& url, std::size_t count, std::size_t conc )
+    {
+        using namespace Utility::http;
+
+        Result                  _result;
+        std::mutex              _mx;   // for _result, _done
+        std::condition_variable _cv;
+        std::size_t             _done(0);
+        std::atomic<std::size_t> _issued(0);
+        _result.micros_.reserve( count );
+
+        std::function<void()>   _next; // outlives the agent's thread, which calls it
+        AsyncAgent  _agent(AsyncAgent::Options().host_conns( long(conc) ).total_conns( long(conc) ).http2( false ));
+        _next = [&]()
+        {
+            if ( _issued++ >= count ) { return; }
+            auto    _start(Clock::now());
+            _agent.get( url, [&, _start]( Response&& resp )
+            {
+                long    _micros(micros_since( _start ));
+                _next(); // before the count: the last one done wakes the caller
+                {
+                    std::lock_guard<std::mutex> _guard(_mx);
+                    _result.micros_.push_back( _micros );
+                    if ( !resp.ok() || resp.code_ != 200 ) { ++_result.errors_; }
+                    if ( ++_done == count ) { _cv.notify_one(); }
+                }
+            } );
+        };
+
+        auto        _start(Clock::now());
+        for ( std::size_t _i(0); _i < conc && _i < count; ++_i ) { _next(); }
+        std::unique_lock<std::mutex> _lock(_mx);
+        _cv.wait( _lock, [&]() { return _done == count; } );
+        _result.secs_ = std::chrono::duration<double>(Clock::now() - _start).count();
+        return _result;
+    }
+
+    void
+    report( char const* mode, std::size_t size, std::size_t conc, Result& result )
+    {
+        auto&   _us(result.micros_);
+        std::sort( _us.begin(), _us.end() );
+        auto    _pct = [&_us]( double pct ) { return _us.empty() ? 0L : _us[std::min( _us.size() - 1, std::size_t(_us.size() * pct) )]; };
+        std::cout << std::setw(6) << mode << std::setw(8) << size << std::setw(6) << conc
+                  << std::setw(11) << (result.secs_ > 0 ? _us.size() / result.secs_ : 0.0)
+                  << std::setw(9) << _pct( 0.5 ) << std::setw(9) << _pct( 0.99 ) << std::setw(9) << _pct( 0.999 )
+                  << std::setw(8) << result.errors_ << std::endl;
+    }
+}
+
+    int main( int ac, char* av[] )
+    {
+        Options     _options;
+        int         _opt;
+        while ( (_opt = ::getopt( ac, av, "u:n:s:c:" )) != -1 )
+        {
+            switch ( _opt )
+            {
+            case 'u': _options.url_   = optarg; break;
+            case 'n': _options.count_ = std::strtoul( optarg, nullptr, 10 ); break;
+            case 's': _options.sizes_ = parse_list( optarg ); break;
+            case 'c': _options.conc_  = parse_list( optarg ); break;
+            default:
+                std::cerr << "Usage: " << av[0] << " [-u <url>] [-n <requests>] [-s <sizes>] [-c <concurrencies>]\n"
+                          << "  lists are comma separated; start httpstub first for the default url" << std::endl;
+                return 1;
+            }
+        }
+        _options.conc_.erase( std::remove( _options.conc_.begin(), _options.conc_.end(), 0 ), _options.conc_.end() );
+        if ( _options.count_ == 0 || _options.sizes_.empty() || _options.conc_.empty() )
+        {
+            std::cerr << av[0] << ": nothing to do" << std::endl;
+            return 1;
+        }
+
+        std::cout << std::fixed << std::setprecision(0)
+                  << _options.count_ << " GETs per row, " << _options.url_ << "\n"
+                  << "  mode    size  conc      req/s      p50      p99    p99.9  errors" << std::endl;
+        for ( std::size_t _size : _options.sizes_ )
+        {
+            std::string _url(_options.url_ + (_options.url_.find( '?' ) == std::string::npos ? "?size=" : "&size=") + std::to_string( _size ));
+            for ( std::size_t _conc : _options.conc_ )
+            {
+                Result  _sync(sync( _url, _options.count_, _conc ));
+                report( "sync", _size, _conc, _sync );
+                Result  _spec(spec( _url, _options.count_, _conc ));
+                report( "spec", _size, _conc, _spec );
+                Result  _async(async( _url, _options.count_, _conc ));
+                report( "async", _size, _conc, _async );
+            }
+        }
+        return 0;
+    }
@@ -0,0 +1,343 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+    /**
+     * httpstub: a stand-in HTTP/1.1 server on the loopback interface,
+     * for testing and benchmarking HttpAgent offline. One thread, epoll.
+     * Every request gets a 200 with a body of 'x's, after a delay; the
+     * defaults can be overridden per request: /anything?size=N&delay=MS.
+     * Connections are kept alive, and pipelined requests are answered
+     * in order. Request bodies (by Content-Length) are read and dropped.
+     * Usage: httpstub [-p port] [-s size] [-d delay_ms]
+     */
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    volatile std::sig_atomic_t  stopping(0);
+
+    void on_signal( int ) { stopping = 1; }
+
+    struct Reply
+    {
+        Clock::time_point   due_;
+        std::size_t         size_;
+        bool                close_;
+    };
+
+    struct Client
+    {
+        std::string         in_;
+        std::string         out_;
+        std::size_t         sent_{0};   // of out_
+        std::deque<Reply>   replies_;   // in request order
+        bool                closing_{false};
+    };
+
+    struct Wakeup
+    {
+        Clock::time_point   due_;
+        int                 fd_;
+        bool operator>( Wakeup const& rhs ) const { return due_ > rhs.due_; }
+    };
+
+    class Stub
+    {
+    public:
+        Stub(std::size_t size, long delay) : size_(size), delay_(delay) {}
+
+        bool listen( int port );
+        void run();
+        std::size_t served() const { return served_; }
+
+    private:
+        std::size_t     size_;
+        long            delay_;  // ms
+        int             ep_{-1};
+        int             lfd_{-1};
+        std::size_t     served_{0};
+        std::string     body_;   // 'x's: bodies are slices of this
+        std::unordered_map<int, Client> clients_;
+        std::priority_queue<Wakeup, std::vector<Wakeup>, std::greater<Wakeup>>  wakeups_;
+
+        void accept_();
+        bool read_( int fd, Client& client );
+        void parse_( int fd, Client& client );
+        void flush_( Client& client );   // due replies into out_
+        bool write_( int fd, Client& client );
+        void drop_( int fd );
+        int timeout_() const;
+    };
+
+    long
+    query_value( std::string const& target, char const* key, long dflt )
+    {
+        auto    _q(target.find( '?' ));
+        if ( _q == std::string::npos ) { return dflt; }
+        std::string _key(std::string(key) + "=");
+        for ( auto _pos(_q + 1); _pos < target.size(); )
+        {
+            auto    _end(target.find( '&', _pos ));
+            if ( _end == std::string::npos ) { _end = target.size(); }
+            if ( target.compare( _pos, _key.size(), _key ) == 0 ) { return std::strtol( target.c_str() + _pos + _key.size(), nullptr, 10 ); }
+            _pos = _end + 1;
+        }
+        return dflt;
+    }
+
+    //!> The value of a header, from the header block (case-insensitive name), or empty
+    std::string
+    header_value( std::string const& head, char const* name )
+    {
+        std::size_t _len(std::strlen( name ));
+        for ( auto _pos(head.find( "\r\n" )); _pos != std::string::npos && _pos + 2 < head.size(); _pos = head.find( "\r\n", _pos + 2 ) )
+        {
+            char const* _line(head.c_str() + _pos + 2);
+            if ( ::strncasecmp( _line, name, _len ) == 0 && _line[_len] == ':' )
+            {
+                char const* _from(_line + _len + 1);
+                while ( *_from == ' ' ) { ++_from; }
+                return std::string(_from, std::strcspn( _from, "\r\n" ));
+            }
+        }
+        return std::string();
+    }
+
+    bool
+    Stub::listen( int port )
+    {
+        lfd_ = ::socket( AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0 );
+        int         _on(1);
+        ::setsockopt( lfd_, SOL_SOCKET, SO_REUSEADDR, &_on, sizeof(_on) );
+        sockaddr_in _addr{};
+        _addr.sin_family      = AF_INET;
+        _addr.sin_port        = htons( port );
+        _addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+        if ( ::bind( lfd_, reinterpret_cast<sockaddr*>(&_addr), sizeof(_addr) ) < 0 || ::listen( lfd_, 1024 ) < 0 )
+        {
+            std::cerr << "httpstub: port " << port << ": " << ::strerror( errno ) << std::endl;
+            return false;
+        }
+        ep_ = ::epoll_create1( 0 );
+        epoll_event _ev{};
+        _ev.events  = EPOLLIN;
+        _ev.data.fd = lfd_;
+        ::epoll_ctl( ep_, EPOLL_CTL_ADD, lfd_, &_ev );
+        return true;
+    }
+
+    void
+    Stub::run()
+    {
+        epoll_event _events[64];
+        while ( !stopping )
+        {
+            int     _n(::epoll_wait( ep_, _events, 64, timeout_() ));
+            if ( _n < 0 && errno != EINTR ) { break; }
+            for ( int _i(0); _i < _n; ++_i )
+            {
+                int     _fd(_events[_i].data.fd);
+                if ( _fd == lfd_ )
+                {
+                    accept_();
+                    continue;
+                }
+                auto    _itr(clients_.find( _fd ));
+                if ( _itr == clients_.end() ) { continue; }
+                if ( (_events[_i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !read_( _fd, _itr->second ) )
+                {
+                    drop_( _fd );
+                    continue;
+                }
+                parse_( _fd, _itr->second );
+                flush_( _itr->second );
+                if ( !write_( _fd, _itr->second ) ) { drop_( _fd ); }
+            }
+            // delayed replies come due
+            auto    _now(Clock::now());
+            while ( !wakeups_.empty() && wakeups_.top().due_ <= _now )
+            {
+                int     _fd(wakeups_.top().fd_);
+                wakeups_.pop();
+                auto    _itr(clients_.find( _fd ));
+                if ( _itr == clients_.end() ) { continue; }
+                flush_( _itr->second );
+                if ( !write_( _fd, _itr->second ) ) { drop_( _fd ); }
+            }
+        }
+        for ( auto& _client : clients_ ) { ::close( _client.first ); }
+        ::close( lfd_ );
+        ::close( ep_ );
+    }
+
+    void
+    Stub::accept_()
+    {
+        int     _fd;
+        while ( (_fd = ::accept4( lfd_, nullptr, nullptr, SOCK_NONBLOCK )) >= 0 )
+        {
+            int         _on(1);
+            ::setsockopt( _fd, IPPROTO_TCP, TCP_NODELAY, &_on, sizeof(_on) );
+            epoll_event _ev{};
+            _ev.events  = EPOLLIN;
+            _ev.data.fd = _fd;
+            ::epoll_ctl( ep_, EPOLL_CTL_ADD, _fd, &_ev );
+            clients_[_fd];
+        }
+    }
+
+    //!> false: the peer is gone
+    bool
+    Stub::read_( int fd, Client& client )
+    {
+        char    _buf[65536];
+        while ( true )
+        {
+            ssize_t _got(::read( fd, _buf, sizeof(_buf) ));
+            if ( _got > 0 )
+            {
+                client.in_.append( _buf, _got );
+                continue;
+            }
+            if ( _got < 0 && errno == EINTR ) { continue; }
+            return _got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+
+    void
+    Stub::parse_( int fd, Client& client )
+    {
+        std::size_t _from(0);
+        while ( !client.closing_ )
+        {
+            auto    _end(client.in_.find( "\r\n\r\n", _from ));
+            if ( _end == std::string::npos ) { break; }
+            std::string _head(client.in_, _from, _end + 2 - _from);
+            std::size_t _length(std::strtoul( header_value( _head, "Content-Length" ).c_str(), nullptr, 10 ));
+            if ( client.in_.size() < _end + 4 + _length ) { break; } // the body is not all here
+
+            // GET /target HTTP/1.1
+            auto        _sp1(_head.find( ' ' ));
+            auto        _sp2(_head.find( ' ', _sp1 + 1 ));
+            std::string _target(_head, _sp1 + 1, _sp2 - _sp1 - 1);
+            bool        _close(_head.compare( _sp2 + 1, 8, "HTTP/1.0" ) == 0 || ::strcasecmp( header_value( _head, "Connection" ).c_str(), "close" ) == 0);
+            long        _delay(query_value( _target, "delay", delay_ ));
+            Reply       _reply{Clock::now() + std::chrono::milliseconds(_delay), std::size_t(query_value( _target, "size", long(size_) )), _close};
+            client.replies_.push_back( _reply );
+            if ( _delay > 0 ) { wakeups_.push( Wakeup{_reply.due_, fd} ); }
+            client.closing_ = _close;
+            _from = _end + 4 + _length;
+        }
+        client.in_.erase( 0, _from );
+    }
+
+    void
+    Stub::flush_( Client& client )
+    {
+        auto    _now(Clock::now());
+        while ( !client.replies_.empty() && client.replies_.front().due_ <= _now )
+        {
+            Reply&  _reply(client.replies_.front());
+            if ( body_.size() < _reply.size_ ) { body_.resize( _reply.size_, 'x' ); }
+            client.out_ += "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: ";
+            client.out_ += std::to_string( _reply.size_ );
+            client.out_ += _reply.close_ ? "\r\nConnection: close\r\n\r\n" : "\r\n\r\n";
+            client.out_.append( body_, 0, _reply.size_ );
+            client.replies_.pop_front();
+            ++served_;
+        }
+    }
+
+    //!> false: done with the connection
+    bool
+    Stub::write_( int fd, Client& client )
+    {
+        while ( client.sent_ < client.out_.size() )
+        {
+            ssize_t _put(::send( fd, client.out_.data() + client.sent_, client.out_.size() - client.sent_, MSG_NOSIGNAL ));
+            if ( _put > 0 )
+            {
+                client.sent_ += _put;
+                continue;
+            }
+            if ( _put < 0 && errno == EINTR ) { continue; }
+            if ( _put < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) ) { break; }
+            return false;
+        }
+        bool        _pending(client.sent_ < client.out_.size());
+        if ( !_pending )
+        {
+            client.out_.clear();
+            client.sent_ = 0;
+            if ( client.closing_ && client.replies_.empty() ) { return false; }
+        }
+        epoll_event _ev{};
+        _ev.events  = _pending ? EPOLLIN | EPOLLOUT : EPOLLIN;
+        _ev.data.fd = fd;
+        ::epoll_ctl( ep_, EPOLL_CTL_MOD, fd, &_ev );
+        return true;
+    }
+
+    void
+    Stub::drop_( int fd )
+    {
+        ::epoll_ctl( ep_, EPOLL_CTL_DEL, fd, nullptr );
+        ::close( fd );
+        clients_.erase( fd );
+    }
+
+    //!> ms until the next delayed reply (a second, at most)
+    int
+    Stub::timeout_() const
+    {
+        if ( wakeups_.empty() ) { return 1000; }
+        auto    _ms(std::chrono::duration_cast<std::chrono::milliseconds>(wakeups_.top().due_ - Clock::now()).count());
+        return _ms < 0 ? 0 : int(_ms + 1);
+    }
+}
+
+    int main( int ac, char* av[] )
+    {
+        int         _port(18080);
+        std::size_t _size(64);
+        long        _delay(0);
+        int         _opt;
+        while ( (_opt = ::getopt( ac, av, "p:s:d:" )) != -1 )
+        {
+            switch ( _opt )
+            {
+            case 'p': _port  = std::atoi( optarg ); break;
+            case 's': _size  = std::strtoul( optarg, nullptr, 10 ); break;
+            case 'd': _delay = std::strtol( optarg, nullptr, 10 ); break;
+            default:
+                std::cerr << "Usage: " << av[0] << " [-p port] [-s size] [-d delay_ms]" << std::endl;
+                return 1;
+            }
+        }
+        std::signal( SIGINT, on_signal );
+        std::signal( SIGTERM, on_signal );
+
+        Stub    _stub(_size, _delay);
+        if ( !_stub.listen( _port ) ) { return 1; }
+        std::cerr << "httpstub: http://127.0.0.1:" << _port << "/ (size " << _size << ", delay " << _delay << " ms)" << std::endl;
+        _stub.run();
+        std::cerr << "httpstub: " << _stub.served() << " served" << std::endl;
+        return 0;
+    }
@@ -0,0 +1,49 @@
+
+#include "Logger.h"
+#include "TimeFns.h"
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+
+    /**
+     * logbench: lines per second per thread through Logger/ to a file.
+     * Usage: logbench [threads] [lines per thread] [file]
+     */
+    int main( int ac, char* av[] )
+    {
+        std::size_t _threads(ac > 1 ? std::strtoul( av[1], nullptr, 10 ) : 4);
+        std::size_t _lines(ac > 2 ? std::strtoul( av[2], nullptr, 10 ) : 200000);
+        char const* _file(ac > 3 ? av[3] : "/tmp/logbench.log");
+
+        Log::LogStream::add_file_logger( _file, Log::LEVEL_ALL );
+
+        std::vector<std::thread>    _workers;
+        std::vector<long long>      _millis(_threads);
+        for ( std::size_t _t(0); _t < _threads; ++_t )
+        {
+            _workers.emplace_back( [&, _t]()
+            {
+                _millis[_t] = Utility::MilliTimer<std::chrono::steady_clock>::time( [&]()
+                {
+                    for ( std::size_t _i(0); _i < _lines; ++_i )
+                    {
+                        InfoLog << "thread " << _t << " line " << _i << " value " << (_i * 0.5);
+                    }
+                } );
+            } );
+        }
+        for ( auto& _worker : _workers ) { _worker.join(); }
+
+        double  _total(0);
+        for ( std::size_t _t(0); _t < _threads; ++_t )
+        {
+            double  _rate(_lines * 1000.0 / (_millis[_t] > 0 ? _millis[_t] : 1));
+            _total += _rate;
+            std::cout << "thread " << _t << ": " << static_cast<long>(_rate) << " lines/s" << std::endl;
+        }
+        std::cout << _threads << " threads: " << static_cast<long>(_total / _threads)
+                  << " lines/s per thread, " << static_cast<long>(_total) << " aggregate" << std::endl;
+        return 0;
+    }
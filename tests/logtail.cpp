@@ -0,0 +1,44 @@
+
+#include "MappedLog.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+    /**
+     * logtail: recover the last entries of a MappedLog segment,
+     * e.g. from a process that crashed.
+     * Usage: logtail <segment> [count]
+     */
+    int main( int ac, char* av[] )
+    {
+        if ( ac < 2 )
+        {
+            std::cerr << "Usage: " << av[0] << " <segment> [count]" << std::endl;
+            return 1;
+        }
+
+        Utility::MappedLog::Reader  _reader(av[1]);
+        if ( !_reader )
+        {
+            std::cerr << "Error: " << ::strerror( _reader.error() ) << std::endl;
+            return 1;
+        }
+
+        std::size_t                 _count(ac > 2 ? std::strtoul( av[2], nullptr, 10 ) : 10);
+        std::vector<std::string>    _last;
+        std::size_t                 _total(0);
+        std::size_t                 _tail(_reader.for_each( [&]( uint32_t seq, char const* data, std::size_t size )
+        {
+            ++_total;
+            if ( _count == 0 ) { return; }
+            if ( _last.size() == _count ) { _last.erase( _last.begin() ); }
+            _last.emplace_back( std::to_string( seq ) + ": " + std::string(data, size) );
+        } ));
+
+        for ( auto const& _entry : _last ) { std::cout << _entry << "\n"; }
+        std::cout << "[" << _total << " records, valid tail at " << _tail
+                  << " of " << _reader.size() << " bytes]" << std::endl;
+        return 0;
+    }
@@ -0,0 +1,70 @@
+#include "Logging.h"
+
+#include <iostream>
+#include <string>
+#include <limits>
+
+    /**
+     * testrecord: structured entries rendered as logfmt and JSON, from
+     * the Record and from its packed copy; prints each line and a verdict.
+     * Usage: testrecord
+     */
+namespace
+{
+    int failed(0);
+
+    void check( Utility::Record const& record, Utility::Record::Format format, std::string const& expected )
+    {
+        char        _buf[512];
+        std::string _packed;
+        record.render( _buf, sizeof(_buf), format );
+        record.pack( _packed );
+        std::string _direct(_buf);
+        Utility::Record::render( _packed.data(), _packed.size(), _buf, sizeof(_buf), format );
+
+        bool    _ok(_direct == expected && std::string(_buf) == expected);
+        if ( !_ok ) { ++failed; }
+        std::cout << (_ok ? "ok   " : "FAIL ") << _direct << "\n";
+        if ( !_ok ) { std::cout << "     packed:   " << _buf << "\n     expected: " << expected << "\n"; }
+    }
+
+    //!> The Record (and its braced list) must not outlive the call: hence one call for both formats
+    void check( Utility::Record const& record, std::string const& logfmt, std::string const& json )
+    {
+        check( record, Utility::Record::Format::LOGFMT, logfmt );
+        check( record, Utility::Record::Format::JSON, json );
+    }
+}
+
+    int main( void )
+    {
+        using Utility::kv;
+        std::string const   _name("a \"quoted\" name");
+        double const        _nan(std::numeric_limits<double>::quiet_NaN());
+        double const        _inf(std::numeric_limits<double>::infinity());
+        Utility::Stamp const _at{1700000000123456789LL};
+
+        check( Utility::Record("order filled", {kv( "id", 42 ), kv( "qty", 7u ), kv( "px", 1.5 ), kv( "ok", true ), kv( "sym", "IBM" )})
+             , "msg=\"order filled\" id=42 qty=7 px=1.5 ok=true sym=IBM"
+             , "{\"msg\":\"order filled\",\"id\":42,\"qty\":7,\"px\":1.5,\"ok\":true,\"sym\":\"IBM\"}" );
+        check( Utility::Record("x", {kv( "name", _name ), kv( "empty", "" ), kv( "at", _at )})
+             , "msg=x name=\"a \\\"quoted\\\" name\" empty=\"\" at=\"2023-11-14T22:13:20.123456Z\""
+             , "{\"msg\":\"x\",\"name\":\"a \\\"quoted\\\" name\",\"empty\":\"\",\"at\":\"2023-11-14T22:13:20.123456Z\"}" );
+        check( Utility::Record("k", {kv( "bad \"key\"", 1 ), kv( "a=b", 2 )})
+             , "msg=k bad__key_=1 a_b=2"
+             , "{\"msg\":\"k\",\"bad \\\"key\\\"\":1,\"a=b\":2}" );
+        check( Utility::Record("r", {kv( "nan", _nan ), kv( "inf", _inf ), kv( "ninf", -_inf )})
+             , "msg=r nan=NaN inf=+Inf ninf=-Inf"
+             , "{\"msg\":\"r\",\"nan\":\"NaN\",\"inf\":\"+Inf\",\"ninf\":\"-Inf\"}" );
+        check( Utility::Record("started", {})
+             , "msg=started"
+             , "{\"msg\":\"started\"}" );
+
+        // the macros, with and without fields, to the default sink (stderr)
+        LOG_KV_INFO(nullptr, "started");
+        LOG_KV_INFO(nullptr, "order filled", kv( "id", 42 ), kv( "sym", "IBM" ));
+
+        if ( failed ) { std::cout << "FAILED: " << failed << std::endl; }
+        else { std::cout << "passed" << std::endl; }
+        return failed ? 1 : 0;
+    }